@@ -12,24 +12,200 @@
 
 #include "adc.h"
 
+/* Makrodefinitioner: */
+#define ADC_MUX_MASK 0x0F /* Bitarna MUX3 - MUX0 i ADMUX, som anger kanal. */
+
+/* Statiska variabler: */
+static struct adc_pin* volatile adc_active = 0; /* Pin vars omvandling pgr, eller 0 om ingen. */
+static void (*volatile adc_handler)(void) = 0;  /* Funktion som tagit AD-omvandlaren i ansprk, eller 0. */
+static uint8_t adc_reference = ADC_REF_AVCC;    /* Referensspnning som senast valdes. */
+static volatile uint8_t adc_discard = 0;        /* Antal omvandlingar som ska slngas innan resultatet. */
+static uint16_t adc_vcc_mv = ADC_VCC_DEFAULT_MV; /* Senast uppmtta matningsspnning i mV. */
+
+/* Statiska funktioner: */
+static bool adc_begin(struct adc_pin* self, const bool start_now);
+static void adc_complete(void);
+static void adc_poll(void);
+static void adc_vcc_on_conversion(struct adc_pin* self);
+static void adc_on_event(const struct event* event);
+
+/********************************************************************************
+* adc_vcc_pin: Analog pin fr mtning av matningsspnningen via bandgap-
+*              kanalen. En extra bit via versampling ger fyra omvand-
+*              lingar, vilket tillsammans med den slngda omvandlingen tar
+*              ca 0.5 ms.
+********************************************************************************/
+static struct adc_pin adc_vcc_pin = {
+	.pin = ADC_CHANNEL_BANDGAP,
+	.callback = adc_vcc_on_conversion,
+	.oversample_bits = 1,
+	.reference = ADC_REF_AVCC,
+};
+
+/********************************************************************************
+* adc_start: Startar AD-omvandling av angiven analog pin utan att vnta p
+*            resultatet. Om en annan omvandling pgr returneras false.
+*
+*            - self: Pekare till analog pin vars insignal ska AD-omvandlas.
+********************************************************************************/
+bool adc_start(struct adc_pin* self)
+{
+	return adc_begin(self, true);
+}
+
 /********************************************************************************
 * adc_read: Lser av en analog insignal och returnerar motsvarande digitala
 *           motsvarighet mellan 0 - 1023.
 *
+*           1. Vi startar en omvandling via adc_start. Om en annan omvandling
+*              pgr vntar vi tills den r klar.
+*
+*           2. Vi vntar tills omvandlingen r klar. Om avbrott r inaktiverade
+*              (exempelvis vid anrop frn en avbrottsrutin) kan ADC_vect inte
+*              exekvera, s d lser vi av flaggan ADIF sjlva via adc_poll.
+*
 *           - self: Pekare till analog pin vars insignal ska AD-omvandlas.
 ********************************************************************************/
 uint16_t adc_read(struct adc_pin* self){
 	
-	ADMUX = (1 << REFS0) | self->pin;
-	ADCSRA = (1 << ADEN) | (1<< ADSC) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
-	while ((ADCSRA & (1 << ADIF)) == 0);
-	ADCSRA = (1 << ADIF);
-	return ADC;
+	while (!adc_start(self))
+	{
+		adc_poll();
+	}
+
+	while (!self->done)
+	{
+		adc_poll();
+	}
+
+	return self->value;
+}
+
+/********************************************************************************
+* adc_read_quiet: Lser av en analog insignal med CPU:n i vilolget ADC Noise
+*                 Reduction under omvandlingen.
+*
+*                 1. Om avbrott r inaktiverade anvnds adc_read, eftersom
+*                    CPU:n d inte kan vckas av ADC_vect.
+*
+*                 2. Vi vntar tills AD-omvandlaren r ledig och frbereder
+*                    omvandlingen utan att starta den.
+*
+*                 3. Vi vljer vilolget ADC Noise Reduction och gr in i
+*                    vilolge tills omvandlingen r klar, varvid omvandlingen
+*                    startas automatiskt nr CPU:n har stannat. Avbrott aktiveras
+*                    direkt fre instruktionen sleep, s att inget avbrott kan
+*                    ske mellan kontrollen av self->done och vilolget. Om
+*                    CPU:n vcks av ett annat avbrott fortstter omvandlingen
+*                    och vi gr in i vilolge igen.
+*
+*                 - self: Pekare till analog pin vars insignal ska AD-omvandlas.
+********************************************************************************/
+uint16_t adc_read_quiet(struct adc_pin* self)
+{
+	if ((SREG & (1 << SREG_I)) == 0) return adc_read(self);
+
+	while (!adc_begin(self, false));
+
+	set_sleep_mode(SLEEP_MODE_ADC);
+	cli();
+	sleep_enable();
+
+	while (!self->done)
+	{
+		sei();
+		sleep_cpu();
+		cli();
+	}
+
+	sleep_disable();
+	sei();
+	return self->value;
+}
+
+/********************************************************************************
+* adc_get_vcc_mv: Returnerar senast uppmtta matningsspnning i millivolt.
+*                 Vrdet skrivs endast frn main-loopen, via callbacken
+*                 adc_vcc_on_conversion eller adc_vcc_measure, och kan drfr
+*                 lsas direkt.
+********************************************************************************/
+uint16_t adc_get_vcc_mv(void)
+{
+	return adc_vcc_mv;
+}
+
+/********************************************************************************
+* adc_vcc_refresh: Startar en mtning av matningsspnningen utan att vnta p
+*                  resultatet, som lagras av adc_vcc_on_conversion.
+********************************************************************************/
+bool adc_vcc_refresh(void)
+{
+	return adc_start(&adc_vcc_pin);
+}
+
+/********************************************************************************
+* adc_vcc_measure: Mter matningsspnningen och vntar p resultatet.
+*                  Eftersom callbacken inte anropas frrn main-loopen tar
+*                  om hand hndelsen berknas spnningen direkt hr.
+********************************************************************************/
+uint16_t adc_vcc_measure(void)
+{
+	(void)adc_read(&adc_vcc_pin);
+	adc_vcc_on_conversion(&adc_vcc_pin);
+	return adc_get_vcc_mv();
+}
+
+/********************************************************************************
+* adc_busy: Indikerar ifall AD-omvandlaren anvnds, vilket r fallet om en
+*           pin har en pgende omvandling eller om en annan modul har tagit
+*           AD-omvandlaren i ansprk.
+********************************************************************************/
+bool adc_busy(void)
+{
+	return adc_active || adc_handler;
+}
+
+/********************************************************************************
+* adc_claim: Tar AD-omvandlaren i ansprk fr en annan modul. Kontrollen grs
+*            med avbrott inaktiverade, s att en samtidig adc_start inte kan
+*            ta AD-omvandlaren mellan kontrollen och tilldelningen. Modulen
+*            frutstts anvnda AVcc som referens.
+*
+*            - handler: Funktion som ska anropas nr en omvandling r klar.
+********************************************************************************/
+bool adc_claim(void (*handler)(void))
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (adc_active || adc_handler) return false;
+		adc_handler = handler;
+		adc_reference = ADC_REF_AVCC;
+	}
+	return true;
+}
+
+/********************************************************************************
+* adc_release: Frigr AD-omvandlaren efter adc_claim. Vi nollstller ADCSRA,
+*              vilket stnger av AD-omvandlaren (ADEN) och avbryter eventuell
+*              pgende omvandling. Eventuell avbrottsflagga ADIF nollstlls
+*              genom att skriva en etta till den.
+********************************************************************************/
+void adc_release(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ADCSRA = (1 << ADIF);
+		adc_handler = 0;
+	}
+	return;
 }
 
 /********************************************************************************
 * adc_get_pwm_values: Lser av en analog insignal och berknar on- och off-tid
-*                     fr PWM-generering, avrundat till nrmaste heltal.
+*                     fr PWM-generering, avrundat till nrmaste heltal. On-
+*                     tiden berknas med heltalsaritmetik som
+*                     (value * pwm_period_us + max / 2) / max, dr produkten
+*                     ryms i 32 bitar.
 *
 *                     - self         : Pekare till analog pin som ska lsas av.
 *                     - pwm_period_us: PWM-perioden (on-tid + off-tid) mtt i
@@ -37,8 +213,9 @@ uint16_t adc_read(struct adc_pin* self){
 ********************************************************************************/
 void adc_get_pwm_values(struct adc_pin* self, uint16_t pwm_period_us)
 {
-	const double duty_cycle = adc_read(self) / 1023.0;
-	self->pwm_on_us =(uint16_t) (duty_cycle * pwm_period_us+0.5);
+	const uint16_t max_value = adc_max_value(self);
+	const uint32_t on_time = (uint32_t)adc_read(self) * pwm_period_us;
+	self->pwm_on_us = (uint16_t)((on_time + max_value / 2) / max_value);
 	self->pwm_off_us = pwm_period_us - self->pwm_on_us;
 	return;
 }
@@ -47,14 +224,26 @@ void adc_get_pwm_values(struct adc_pin* self, uint16_t pwm_period_us)
 * adc_init: Initierar analog pin fr avlsning och AD-omvandling av insignaler,
 *			Och nollstller pwm vrderna.
 *
+*			Funktionen adc_on_event stts till att ta om hand hndelser
+*			av typen EVENT_ADC, s att callbacks anropas.
+*
 *           - self: Pekare till analog pin som ska anvndas fr AD-omvandling.
 *           - pin : Analog pin som ska lsas fr AD-omvandling.
 ********************************************************************************/
 void adc_init(struct adc_pin* self, uint8_t pin)
 {
+	event_set_handler(EVENT_ADC, adc_on_event);
 	self->pin = pin;
 	self->pwm_off_us = 0;
 	self->pwm_on_us = 0;
+	self->value = 0;
+	self->done = false;
+	self->callback = 0;
+	self->oversample_bits = 0;
+	self->samples_left = 0;
+	self->sum = 0;
+	self->reference = ADC_REF_AVCC;
+	self->pwm = 0;
 	(void)adc_read(self);
 	return;
 }
@@ -83,3 +272,186 @@ void adc_delay_off(struct adc_pin* self){
 	return;
 }
 
+/********************************************************************************
+* adc_complete: Slutfr pgende omvandling. Resultatet lagras i aktuell pin,
+*               som markeras som klar, varefter AD-omvandlaren frigrs innan
+*               en hndelse skickas till main-loopen, dr eventuell callback
+*               anropas via adc_on_event, s att callbacken kan starta en ny
+*               omvandling direkt.
+*
+*               Vid versampling summeras i stllet varje omvandling tills
+*               4^n omvandlingar har gjorts, varefter resultatet blir summan
+*               skiftad n steg t hger. Eftersom nsta omvandling redan har
+*               startat nr avbrottet sker i free running mode inaktiveras
+*               ADATE nr en omvandling terstr, s att ingen ytterligare
+*               omvandling startas efter den sista.
+*
+*               Eventuell kopplad PWM-utgng uppdateras med resultatet direkt
+*               i avbrottsrutinen, eftersom uppdateringen endast r en
+*               skiftning och en skrivning till OCRnx.
+*               Omvandlingar som ska slngas efter byte av referens eller
+*               kanal rknas inte. Utan free running mode startas nsta
+*               omvandling direkt via ADSC.
+********************************************************************************/
+static void adc_complete(void)
+{
+	struct adc_pin* self = adc_active;
+	if (!self) return;
+
+	if (adc_discard)
+	{
+		adc_discard--;
+		if (!self->oversample_bits) ADCSRA |= (1 << ADSC);
+		return;
+	}
+
+	if (self->oversample_bits)
+	{
+		self->sum += ADC;
+		if (--self->samples_left == 1) ADCSRA &= ~(1 << ADATE);
+		if (self->samples_left) return;
+		self->value = self->sum >> self->oversample_bits;
+	}
+	else
+	{
+		self->value = ADC;
+	}
+
+	adc_active = 0;
+	self->done = true;
+
+	if (self->pwm) pwm_set_from_adc(self->pwm, self->value, self->oversample_bits);
+	if (self->callback) event_post(EVENT_ADC, self->value, self);
+	return;
+}
+
+/********************************************************************************
+* adc_on_event: Anropas frn main-loopen vid hndelse av typen EVENT_ADC och
+*               anropar callbacken fr pinnen som skickade hndelsen.
+*
+*               - event: Hndelsen, dr source pekar p aktuell pin.
+********************************************************************************/
+static void adc_on_event(const struct event* event)
+{
+	struct adc_pin* self = event->source;
+	if (self->callback) self->callback(self);
+	return;
+}
+
+/********************************************************************************
+* adc_poll: Slutfr pgende omvandling utan avbrottsrutinen om avbrott r
+*           inaktiverade och omvandlingen r klar, vilket indikeras av att
+*           flaggan ADIF i ADCSRA r ettstlld. Flaggan nollstlls genom att
+*           skriva en etta till den. Om avbrott r aktiverade grs ingenting,
+*           d ADC_vect d skter detta.
+********************************************************************************/
+static void adc_poll(void)
+{
+	if ((SREG & (1 << SREG_I)) == 0 && (ADCSRA & (1 << ADIF)))
+	{
+		ADCSRA |= (1 << ADIF);
+		if (adc_handler) adc_handler();
+		else adc_complete();
+	}
+	return;
+}
+
+/********************************************************************************
+* ISR (ADC_vect): Avbrottsrutin som ger rum nr en AD-omvandling r klar.
+*                 Om AD-omvandlaren har tagits i ansprk via adc_claim anropas
+*                 angiven funktion, annars slutfrs omvandlingen fr aktuell
+*                 pin. Flaggan ADIF nollstlls automatiskt av hrdvaran.
+********************************************************************************/
+ISR (ADC_vect)
+{
+	if (adc_handler) adc_handler();
+	else adc_complete();
+	return;
+}
+
+/********************************************************************************
+* adc_begin: Frbereder AD-omvandling av angiven analog pin och startar den
+*            direkt om start_now r true. Annars startar omvandlingen nr
+*            CPU:n frstts i vilolget ADC Noise Reduction. Om en annan
+*            omvandling pgr returneras false.
+*
+*            1. Vi kontrollerar med avbrott inaktiverade att ingen omvandling
+*               pgr och att AD-omvandlaren inte har tagits i ansprk via
+*               adc_claim, och sparar i s fall vilken pin som omvandlas.
+*
+*            2. Vi vljer pinnens referensspnning samt angiven pin i ADMUX
+*               (ADC Multiplexer Selection Register). Om referensen har bytts
+*               sedan frra omvandlingen slngs ADC_REF_SETTLE_DISCARDS
+*               omvandlingar, och vid byte till bandgapkanalen slngs
+*               ADC_BANDGAP_SETTLE_DISCARDS omvandlingar.
+*
+*            3. Vid versampling nollstlls summan och antalet omvandlingar
+*               stts till 4^n. Free running mode aktiveras via biten ADATE
+*               (ADC Auto Trigger Enable) med triggerklla noll i ADCSRB, s
+*               att nsta omvandling startar direkt nr fregende r klar.
+*
+*            4. Vi aktiverar AD-omvandlaren (ADEN), startar omvandlingen
+*               (ADSC) om start_now r true och aktiverar avbrott nr
+*               omvandlingen r klar (ADIE). Eventuell gammal avbrottsflagga
+*               ADIF nollstlls genom att skriva en etta till den.
+*
+*            - self     : Pekare till analog pin vars insignal ska AD-omvandlas.
+*            - start_now: true om omvandlingen ska startas direkt.
+********************************************************************************/
+static bool adc_begin(struct adc_pin* self, const bool start_now)
+{
+	const uint8_t start = start_now ? (1 << ADSC) : 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (adc_active || adc_handler) return false;
+		adc_active = self;
+		self->done = false;
+
+		if (self->reference != adc_reference)
+		{
+			adc_discard = ADC_REF_SETTLE_DISCARDS;
+			adc_reference = self->reference;
+		}
+		else if (self->pin == ADC_CHANNEL_BANDGAP && (ADMUX & ADC_MUX_MASK) != ADC_CHANNEL_BANDGAP)
+		{
+			adc_discard = ADC_BANDGAP_SETTLE_DISCARDS;
+		}
+		else
+		{
+			adc_discard = 0;
+		}
+
+		ADMUX = self->reference | self->pin;
+
+		if (self->oversample_bits)
+		{
+			self->sum = 0;
+			self->samples_left = 1 << (2 * self->oversample_bits);
+			ADCSRB = 0x00;
+			ADCSRA = (1 << ADEN) | start | (1 << ADATE) | (1 << ADIE) | (1 << ADIF) | ADC_PRESCALER;
+		}
+		else
+		{
+			ADCSRA = (1 << ADEN) | start | (1 << ADIE) | (1 << ADIF) | ADC_PRESCALER;
+		}
+	}
+	return true;
+}
+
+/********************************************************************************
+* adc_vcc_on_conversion: Anropas frn main-loopen nr mtningen av bandgap-
+*                        referensen r klar och berknar matningsspnningen.
+*                        Ett resultat p noll ignoreras fr att undvika
+*                        division med noll.
+*
+*                        - self: Pekare till bandgapkanalens analoga pin.
+********************************************************************************/
+static void adc_vcc_on_conversion(struct adc_pin* self)
+{
+	if (self->value)
+	{
+		adc_vcc_mv = (uint16_t)(((uint32_t)ADC_BANDGAP_MV * adc_max_value(self) + self->value / 2) / self->value);
+	}
+	return;
+}
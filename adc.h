@@ -27,11 +27,68 @@
 
 /* Inkluderingsderektiv:*/
 #include "misc.h"
+#include "pwm.h"
+#include "event.h"
 #include "setup.h"
 
 #define PO1 0 /* Potensiometer kopplad till ingng A0 p aruduinot.*/
 #define PO2 1 /* Potensiometer kopplad till ingng A1 p aruduinot.*/
 
+/********************************************************************************
+* versampling: Genom att summera 4^n omvandlingar och skifta summan n steg
+*               t hger erhlls n extra bitars upplsning, frutsatt att
+*               insignalen har ett brus p minst ca 1 LSB (vilket TMP36 har).
+*               Omvandlingarna sker i free running mode, s att CPU:n endast
+*               belastas av en kort avbrottsrutin per omvandling. Med 125 kHz
+*               AD-klocka (13 klockcykler per omvandling) blir det ca 9600
+*               omvandlingar per sekund, vilket ger fljande enligt
+*               tools/hostsim/oversample.c, dr RMS-felet gller fr en
+*               ideal AD-omvandlare med 1 LSB normalfrdelat brus:
+*
+*               n   Upplsning   Omvandlingar   Resultat/s   C per LSB   RMS-fel
+*               0     10 bit           1           9615          0.49      0.49 C
+*               1     11 bit           4           2404          0.24      0.26 C
+*               2     12 bit          16            601          0.12      0.13 C
+*               3     13 bit          64            150          0.06      0.07 C
+*
+*               Utan brus blir RMS-felet ca 0.14 C oavsett n.
+********************************************************************************/
+#define ADC_OVERSAMPLE_MAX_BITS 3 /* Max antal extra bitar, 4^3 * 1023 ryms i 16 bitar. */
+#define ADC_PRESCALER ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0)) /* Prescaler 128, ger 125 kHz AD-klocka. */
+
+/********************************************************************************
+* Referensspnning: Som standard anvnds AVcc som referens, vilket innebr
+*                   att resultatet beror p matningsspnningen (mellan ca
+*                   4.7 och 5.2 V vid USB-matning). Matningsspnningen mts
+*                   drfr regelbundet genom att lsa av den interna
+*                   bandgapreferensen (ca 1.1 V) med AVcc som referens:
+*
+*                   vcc_mv = ADC_BANDGAP_MV * 1023 / adc_value
+*
+*                   Alternativt kan den interna 1.1 V-referensen anvndas fr
+*                   en pin, se adc_set_reference. Vid byte av referens mste
+*                   kondensatorn p AREF (100 nF p Arduino Uno) hinna laddas
+*                   om, vilket tar flera millisekunder. ADC_REF_SETTLE_DISCARDS
+*                   omvandlingar slngs drfr efter byte av referens och
+*                   ADC_BANDGAP_SETTLE_DISCARDS efter byte till bandgapkanalen.
+********************************************************************************/
+#define ADC_REF_AVCC (1 << REFS0)                    /* AVcc som referens. */
+#define ADC_REF_INTERNAL ((1 << REFS1) | (1 << REFS0)) /* Intern 1.1 V-referens. */
+#define ADC_CHANNEL_BANDGAP 14  /* Kanal fr den interna bandgapreferensen. */
+#define ADC_VCC_DEFAULT_MV 5000 /* Antagen matningsspnning innan den har mtts. */
+
+#ifndef ADC_BANDGAP_MV
+#define ADC_BANDGAP_MV 1100 /* Bandgapreferensens spnning i mV (1.0 - 1.2 V), kan kalibreras. */
+#endif
+
+#ifndef ADC_REF_SETTLE_DISCARDS
+#define ADC_REF_SETTLE_DISCARDS 160 /* Ca 17 ms, ca 5 tidskonstanter med 100 nF p AREF. */
+#endif
+
+#ifndef ADC_BANDGAP_SETTLE_DISCARDS
+#define ADC_BANDGAP_SETTLE_DISCARDS 1 /* Bandgapreferensen behver ca 70 us fr att starta. */
+#endif
+
 /********************************************************************************
 * adc: Strukt fr implementering av AD-omvandlare, som mjliggr avlsning
 *      av insignaler frn analoga pinnar samt berkning av on- och off-tid fr
@@ -41,6 +98,14 @@ struct adc_pin{
 	uint8_t pin;			/* pin: anger vilken pin p arduinot som lses av.*/
 	uint16_t pwm_on_us;		/* pwm_on_us: Anger hur lnge en signal skall vara hg vid PWM styrning.*/
 	uint16_t pwm_off_us;	/* pwm_off_us: Anger hur lnge en signal skall vara lg vid PWM styrning.*/
+	volatile uint16_t value;	/* value: Resultatet frn senast slutfrda AD-omvandling.*/
+	volatile bool done;			/* done: Indikerar att en startad AD-omvandling r slutfrd.*/
+	void (*callback)(struct adc_pin* self); /* callback: Anropas frn main-loopen nr omvandlingen r klar (eller 0).*/
+	uint8_t oversample_bits;	/* oversample_bits: Antal extra bitar via versampling (0 - 3).*/
+	volatile uint8_t samples_left;	/* samples_left: Antal omvandlingar kvar vid versampling.*/
+	volatile uint16_t sum;		/* sum: Summan av omvandlingarna vid versampling.*/
+	uint8_t reference;			/* reference: Referensspnning, ADC_REF_AVCC eller ADC_REF_INTERNAL.*/
+	struct pwm* pwm;			/* pwm: PWM-utgng som uppdateras efter varje omvandling (eller 0).*/
 };
 
 /********************************************************************************
@@ -52,14 +117,179 @@ struct adc_pin{
 ********************************************************************************/
 void adc_init(struct adc_pin* self, uint8_t pin);
 
+/********************************************************************************
+* adc_start: Startar AD-omvandling av angiven analog pin utan att vnta p
+*            resultatet. Nr omvandlingen r klar (efter ca 104 us) lagras
+*            resultatet i self->value, self->done ettstlls och eventuell
+*            callback anropas frn main-loopen via event_dispatch. Eftersom det
+*            endast finns en AD-omvandlare returneras false om en annan
+*            omvandling pgr, annars true.
+*
+*            - self: Pekare till analog pin vars insignal ska AD-omvandlas.
+********************************************************************************/
+bool adc_start(struct adc_pin* self);
+
+/********************************************************************************
+* adc_set_callback: Stter funktion som ska anropas varje gng en omvandling
+*                   p angiven pin r klar. Avbrottsrutinen ADC_vect skickar
+*                   en hndelse av typen EVENT_ADC, varefter funktionen
+*                   anropas frn main-loopen via event_dispatch med avbrott
+*                   aktiverade. Anropet sker drmed inte frrn main-loopen
+*                   hinner ta om hand hndelsen, men self->value r d
+*                   fortfarande giltigt s lnge ingen ny omvandling har
+*                   startats p samma pin.
+*
+*                   - self    : Pekare till analog pin.
+*                   - callback: Funktion som ska anropas, eller 0 fr ingen.
+********************************************************************************/
+static inline void adc_set_callback(struct adc_pin* self, 
+                                    void (*callback)(struct adc_pin* self))
+{
+	self->callback = callback;
+	return;
+}
+
+/********************************************************************************
+* adc_set_oversampling: Stter antalet extra bitar som ska erhllas via
+*                       versampling p angiven pin. Varje resultat bestr d
+*                       av 4^bits omvandlingar och hamnar mellan 0 och
+*                       1023 * 2^bits, se adc_max_value.
+*
+*                       - self: Pekare till analog pin.
+*                       - bits: Antal extra bitar, 0 - ADC_OVERSAMPLE_MAX_BITS.
+********************************************************************************/
+static inline void adc_set_oversampling(struct adc_pin* self, 
+                                        const uint8_t bits)
+{
+	self->oversample_bits = bits > ADC_OVERSAMPLE_MAX_BITS ? ADC_OVERSAMPLE_MAX_BITS : bits;
+	return;
+}
+
+/********************************************************************************
+* adc_set_pwm: Kopplar angiven PWM-utgng till angiven pin, s att utgngens
+*              duty cycle stts till value / adc_max_value varje gng en
+*              omvandling r klar, innan eventuell callback anropas.
+*
+*              - self: Pekare till analog pin.
+*              - pwm : Pekare till initierad PWM-utgng, eller 0 fr ingen.
+********************************************************************************/
+static inline void adc_set_pwm(struct adc_pin* self, 
+                               struct pwm* pwm)
+{
+	self->pwm = pwm;
+	return;
+}
+
+/********************************************************************************
+* adc_set_reference: Stter referensspnning fr angiven pin. Med den interna
+*                    1.1 V-referensen blir resultatet oberoende av matnings-
+*                    spnningen, men insignalen fr d vara hgst 1.1 V.
+*
+*                    - self     : Pekare till analog pin.
+*                    - reference: ADC_REF_AVCC eller ADC_REF_INTERNAL.
+********************************************************************************/
+static inline void adc_set_reference(struct adc_pin* self, 
+                                     const uint8_t reference)
+{
+	self->reference = reference == ADC_REF_INTERNAL ? ADC_REF_INTERNAL : ADC_REF_AVCC;
+	return;
+}
+
+/********************************************************************************
+* adc_max_value: Returnerar strsta mjliga resultat fr angiven pin, vilket
+*                r 1023 utan versampling och 1023 * 2^n med n extra bitar.
+*
+*                - self: Pekare till analog pin.
+********************************************************************************/
+static inline uint16_t adc_max_value(const struct adc_pin* self)
+{
+	return 1023U << self->oversample_bits;
+}
+
+/********************************************************************************
+* adc_get_vcc_mv: Returnerar senast uppmtta matningsspnning i millivolt,
+*                 eller ADC_VCC_DEFAULT_MV om den inte har mtts n.
+********************************************************************************/
+uint16_t adc_get_vcc_mv(void);
+
+/********************************************************************************
+* adc_reference_mv: Returnerar referensspnningen fr angiven pin i millivolt,
+*                   dvs. senast uppmtta matningsspnning fr AVcc eller
+*                   ADC_BANDGAP_MV fr den interna referensen. Anvnds fr att
+*                   omvandla ett resultat till spnning:
+*
+*                   voltage_mv = value * adc_reference_mv(self) / adc_max_value(self)
+*
+*                   - self: Pekare till analog pin.
+********************************************************************************/
+static inline uint16_t adc_reference_mv(const struct adc_pin* self)
+{
+	return self->reference == ADC_REF_INTERNAL ? ADC_BANDGAP_MV : adc_get_vcc_mv();
+}
+
+/********************************************************************************
+* adc_vcc_refresh: Startar en mtning av matningsspnningen via bandgap-
+*                  kanalen utan att vnta p resultatet, som lagras nr
+*                  mtningen r klar (efter ca 0.5 ms). Returnerar false om
+*                  AD-omvandlaren r upptagen, s att anroparen kan frska
+*                  igen senare. Funktionen kan anropas frn en avbrottsrutin.
+********************************************************************************/
+bool adc_vcc_refresh(void);
+
+/********************************************************************************
+* adc_vcc_measure: Mter matningsspnningen och vntar p resultatet, som
+*                  returneras i millivolt. Lmplig vid initiering.
+********************************************************************************/
+uint16_t adc_vcc_measure(void);
+
 /********************************************************************************
 * adc_read: Lser av en analog insignal och returnerar motsvarande digitala
-*           motsvarighet mellan 0 - 1023.
+*           motsvarighet mellan 0 - 1023 (eller adc_max_value vid
+*           versampling). Funktionen startar en omvandling
+*           via adc_start och vntar tills den r klar.
 *
 *           - self: Pekare till analog pin vars insignal ska AD-omvandlas.
 ********************************************************************************/
 uint16_t adc_read(struct adc_pin* self);
 
+/********************************************************************************
+* adc_read_quiet: Lser av en analog insignal p samma stt som adc_read, men
+*                 frstter CPU:n i vilolget ADC Noise Reduction under
+*                 omvandlingen, s att brus frn CPU:n och I/O-portar inte
+*                 pverkar resultatet. Eftersom I/O-klockan stngs av under
+*                 vilolget stannar ven USART samt timer 0 och 1 (och drmed
+*                 systemticken) under omvandlingen, vilket tar ca 104 us
+*                 per omvandling. Funktionen br drfr endast anropas frn
+*                 main-loopen nr ingen seriell verfring pgr. Om avbrott
+*                 r inaktiverade kan CPU:n inte vckas, s d anvnds adc_read.
+*
+*                 - self: Pekare till analog pin vars insignal ska AD-omvandlas.
+********************************************************************************/
+uint16_t adc_read_quiet(struct adc_pin* self);
+
+/********************************************************************************
+* adc_busy: Indikerar ifall en omvandling pgr, eller om AD-omvandlaren har
+*           tagits i ansprk via adc_claim.
+********************************************************************************/
+bool adc_busy(void);
+
+/********************************************************************************
+* adc_claim: Tar AD-omvandlaren i ansprk fr en annan modul, exempelvis
+*            adc_scan. Angiven funktion anropas d frn ADC_vect (eller nr
+*            flaggan ADIF lses av med avbrott inaktiverade) i stllet fr
+*            att resultatet lagras i en analog pin. Under tiden returnerar
+*            adc_start false. Returnerar false om AD-omvandlaren redan anvnds.
+*
+*            - handler: Funktion som ska anropas nr en omvandling r klar.
+********************************************************************************/
+bool adc_claim(void (*handler)(void));
+
+/********************************************************************************
+* adc_release: Frigr AD-omvandlaren efter adc_claim. AD-omvandlaren stngs
+*              av, vilket avbryter eventuell pgende omvandling.
+********************************************************************************/
+void adc_release(void);
+
 /********************************************************************************
 * adc_get_pwm_values: Lser av en analog insignal och berknar on- och off-tid
 *                     fr PWM-generering, avrundat till nrmaste heltal.
@@ -73,7 +303,9 @@ void adc_get_pwm_values(struct adc_pin* self, uint16_t pwm_period_us);
 /********************************************************************************
 * adc_delay_on: Aktiverar en frdrjning p perioden av hg signal vid pwm styrning
 				enligt tidigare avlst vrde. 
-				Frdrjningen blir vrdet p pwm_on_us i microsekunder
+				Frdrjningen blir vrdet p pwm_on_us i microsekunder.
+				CPU:n r upptagen under hela frdrjningen, s fr PWM p
+				en av timerkretsarnas utgngar br adc_set_pwm anvndas.
 				
 				- self         : Pekare till analog pin som har lsts av.
 ********************************************************************************/
@@ -82,7 +314,9 @@ void adc_delay_on(struct adc_pin* self);
 /********************************************************************************
 * adc_delay_off: Aktiverar en frdrjning p perioden av lg signal vid pwm styrning
 				enligt tidigare avlst vrde. 
-				Frdrjningen blir vrdet p pwm_off_us i microsekunder
+				Frdrjningen blir vrdet p pwm_off_us i microsekunder.
+				CPU:n r upptagen under hela frdrjningen, s fr PWM p
+				en av timerkretsarnas utgngar br adc_set_pwm anvndas.
 				
 				- self         : Pekare till analog pin som har lsts av.
 ********************************************************************************/
@@ -0,0 +1,246 @@
+/*
+ * adc_scan.c
+ */ 
+
+/********************************************************************************
+* adc_scan.c: Innehller funktionsdefinitioner fr avlsning av flera analoga
+*             pinnar i tur och ordning via AD-omvandlarens free running mode.
+********************************************************************************/
+
+#include "adc_scan.h"
+
+/* Makrodefinitioner: */
+#define ADC_SCAN_MASK (ADC_SCAN_BUFFER_SIZE - 1) /* Mask fr index i ringbufferten. */
+
+/* Statiska variabler: */
+static struct adc_scan_channel* adc_scan_channels[ADC_SCAN_MAX_CHANNELS]; /* Registrerade kanaler. */
+static uint8_t adc_scan_count = 0;			/* Antal registrerade kanaler. */
+static uint8_t adc_scan_index = 0;			/* Index fr senast schemalagda kanal. */
+static uint8_t adc_scan_mux = 0;			/* Pin som senast skrevs till ADMUX. */
+static volatile bool adc_scan_active = false;	/* Indikerar ifall avlsningen pgr. */
+static struct adc_scan_channel* adc_scan_current = 0;	/* Kanal fr omvandlingen som slutfrs hrnst. */
+static bool adc_scan_current_discard = true;			/* true om den omvandlingen ska slngas. */
+static struct adc_scan_channel* adc_scan_next = 0;		/* Kanal fr omvandlingen drefter. */
+static bool adc_scan_next_discard = true;				/* true om den omvandlingen ska slngas. */
+
+/* Statiska funktioner: */
+static void adc_scan_complete(void);
+static struct adc_scan_channel* adc_scan_select(void);
+static void adc_scan_put(struct adc_scan_channel* self, const uint16_t value);
+
+/********************************************************************************
+* adc_scan_channel_init: Initierar kanal fr avlsning via adc_scan.
+*
+*                        - self   : Pekare till kanalen.
+*                        - pin    : Analog pin som ska lsas av.
+*                        - divider: Kanalen lses av var divider:e varv (minst 1).
+********************************************************************************/
+void adc_scan_channel_init(struct adc_scan_channel* self, 
+                           const uint8_t pin, 
+                           const uint8_t divider)
+{
+	self->pin = pin;
+	self->divider = divider ? divider : 1;
+	self->countdown = 1;
+	self->head = 0;
+	self->tail = 0;
+	self->latest = 0;
+	self->dropped = 0;
+	return;
+}
+
+/********************************************************************************
+* adc_scan_add: Lgger till kanal i listan ver kanaler som ska lsas av.
+*               Returnerar false om listan r full eller om avlsningen pgr.
+*
+*               - self: Pekare till kanalen som ska lggas till.
+********************************************************************************/
+bool adc_scan_add(struct adc_scan_channel* self)
+{
+	if (adc_scan_active || adc_scan_count >= ADC_SCAN_MAX_CHANNELS) return false;
+	adc_scan_channels[adc_scan_count++] = self;
+	return true;
+}
+
+/********************************************************************************
+* adc_scan_start: Startar avlsning av registrerade kanaler.
+*
+*                 1. Vi tar AD-omvandlaren i ansprk via adc_claim, s att
+*                    ADC_vect anropar adc_scan_complete. Om AD-omvandlaren
+*                    anvnds returneras false.
+*
+*                 2. Samtliga kanaler stts att st p tur under frsta varvet
+*                    och frsta kanalen vljs. Frsta omvandlingen slngs,
+*                    eftersom den tar lngre tid och kanalen precis har valts.
+*                    Omvandlingen drefter startar automatiskt p samma kanal
+*                    och behlls.
+*
+*                 3. Free running mode aktiveras via biten ADATE med trigger-
+*                    klla noll i ADCSRB och frsta omvandlingen startas.
+********************************************************************************/
+bool adc_scan_start(void)
+{
+	if (!adc_scan_count || adc_scan_active) return false;
+	if (!adc_claim(adc_scan_complete)) return false;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t i = 0; i < adc_scan_count; ++i)
+		{
+			adc_scan_channels[i]->countdown = 1;
+		}
+
+		adc_scan_index = adc_scan_count - 1;
+		adc_scan_current = adc_scan_select();
+		adc_scan_current_discard = true;
+		adc_scan_next = adc_scan_current;
+		adc_scan_next_discard = false;
+		adc_scan_mux = adc_scan_current->pin;
+		adc_scan_active = true;
+
+		ADMUX = (1 << REFS0) | adc_scan_mux;
+		ADCSRB = 0x00;
+		ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE) | (1 << ADIF) | ADC_PRESCALER;
+	}
+	return true;
+}
+
+/********************************************************************************
+* adc_scan_stop: Stoppar avlsningen och frigr AD-omvandlaren via
+*                adc_release, vilket ven avbryter pgende omvandling.
+********************************************************************************/
+void adc_scan_stop(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (adc_scan_active)
+		{
+			adc_scan_active = false;
+			adc_release();
+		}
+	}
+	return;
+}
+
+/********************************************************************************
+* adc_scan_running: Indikerar ifall avlsningen pgr.
+********************************************************************************/
+bool adc_scan_running(void)
+{
+	return adc_scan_active;
+}
+
+/********************************************************************************
+* adc_scan_read: Lser ldsta olsta resultatet fr angiven kanal. Eftersom
+*                resultatet skrivs till bufferten innan head rknas upp i
+*                avbrottsrutinen behver avbrott inte inaktiveras.
+*
+*                - self : Pekare till kanalen som ska lsas av.
+*                - value: Adress dr resultatet ska lagras.
+********************************************************************************/
+bool adc_scan_read(struct adc_scan_channel* self, uint16_t* value)
+{
+	const uint8_t tail = self->tail;
+	if (tail == self->head) return false;
+	*value = self->buffer[tail];
+	self->tail = (tail + 1) & ADC_SCAN_MASK;
+	return true;
+}
+
+/********************************************************************************
+* adc_scan_complete: Anropas frn ADC_vect nr en omvandling r klar.
+*
+*                    1. Resultatet lagras fr aktuell kanal, om omvandlingen
+*                       inte ska slngas.
+*
+*                    2. Omvandlingen som redan har startat blir aktuell.
+*
+*                    3. Vi vljer kanal fr omvandlingen drefter. Om den
+*                       pgende omvandlingen ska slngas grs en till p
+*                       samma kanal. Annars vljs nsta kanal som str p tur
+*                       och skrivs till ADMUX. Om kanalen skiljer sig frn
+*                       den pgende ska frsta omvandlingen slngas. Om ingen
+*                       kanal str p tur grs en omvandling som slngs.
+********************************************************************************/
+static void adc_scan_complete(void)
+{
+	const uint16_t value = ADC;
+
+	if (adc_scan_current && !adc_scan_current_discard)
+	{
+		adc_scan_put(adc_scan_current, value);
+	}
+
+	adc_scan_current = adc_scan_next;
+	adc_scan_current_discard = adc_scan_next_discard;
+
+	if (adc_scan_current && adc_scan_current_discard)
+	{
+		adc_scan_next_discard = false;
+		return;
+	}
+
+	adc_scan_next = adc_scan_select();
+
+	if (!adc_scan_next)
+	{
+		adc_scan_next_discard = true;
+	}
+	else if (adc_scan_next->pin != adc_scan_mux)
+	{
+		adc_scan_next_discard = ADC_SCAN_DISCARD_FIRST;
+		adc_scan_mux = adc_scan_next->pin;
+		ADMUX = (1 << REFS0) | adc_scan_mux;
+	}
+	else
+	{
+		adc_scan_next_discard = false;
+	}
+	return;
+}
+
+/********************************************************************************
+* adc_scan_select: Returnerar nsta kanal som str p tur, eller 0 om ingen
+*                  kanal str p tur under resten av varvet. Varje kanal
+*                  passeras en gng per varv, varvid dess nedrknare rknas
+*                  ned. Nr nedrknaren nr noll str kanalen p tur och
+*                  nedrknaren stts till kanalens delare.
+********************************************************************************/
+static struct adc_scan_channel* adc_scan_select(void)
+{
+	for (uint8_t i = 0; i < adc_scan_count; ++i)
+	{
+		if (++adc_scan_index >= adc_scan_count) adc_scan_index = 0;
+		struct adc_scan_channel* self = adc_scan_channels[adc_scan_index];
+
+		if (--self->countdown == 0)
+		{
+			self->countdown = self->divider;
+			return self;
+		}
+	}
+	return 0;
+}
+
+/********************************************************************************
+* adc_scan_put: Lagrar resultat fr angiven kanal. Om ringbufferten r full
+*               slngs resultatet, men det lagras alltid som senaste resultat.
+*
+*               - self : Pekare till kanalen.
+*               - value: Resultatet som ska lagras.
+********************************************************************************/
+static void adc_scan_put(struct adc_scan_channel* self, const uint16_t value)
+{
+	const uint8_t next = (self->head + 1) & ADC_SCAN_MASK;
+	self->latest = value;
+
+	if (next == self->tail)
+	{
+		self->dropped++;
+		return;
+	}
+
+	self->buffer[self->head] = value;
+	self->head = next;
+	return;
+}
@@ -0,0 +1,139 @@
+/*
+ * adc_scan.h
+ */ 
+
+/********************************************************************************
+* adc_scan.h: Innehller funktionalitet fr att lsa av flera analoga pinnar
+*             i tur och ordning (round robin) utan att CPU:n behver vnta.
+*             Varje kanal registreras via strukten adc_scan_channel, varefter
+*             AD-omvandlaren krs i free running mode och avbrottsrutinen
+*             ADC_vect byter kanal via ADMUX mellan omvandlingarna. Resultaten
+*             lagras i en ringbuffert per kanal och lses av frn main-loopen.
+*
+*             Eftersom nsta omvandling redan har startat nr avbrottet sker
+*             fr ett nytt vrde i ADMUX effekt frst p omvandlingen drefter.
+*             Schemalggaren ligger drfr alltid en omvandling fre. Den frsta
+*             omvandlingen efter byte av kanal slngs (om ADC_SCAN_DISCARD_FIRST
+*             r 1), eftersom sample-and-hold-kondensatorn d inte hunnit
+*             laddas om helt vid hgohmiga kllor.
+*
+*             Med 125 kHz AD-klocka blir det ca 9600 omvandlingar per sekund
+*             totalt, vilket ger ca 4800 resultat per sekund frdelat ver
+*             samtliga kanaler (ca 9600 med en kanal eller utan slngda
+*             omvandlingar). Varje kanal kan lsas av mer sllan genom att
+*             ange en delare, exempelvis lses en kanal med delare 4 av var
+*             fjrde varv. Om ingen kanal str p tur grs en omvandling vars
+*             resultat slngs, s att AD-omvandlaren aldrig str still.
+*
+*             Medan avlsningen pgr anvnds AD-omvandlaren enbart av denna
+*             modul, s adc_start returnerar false och adc_read vntar tills
+*             avlsningen har stoppats via adc_scan_stop. Avbrottsrutiner som
+*             tar lngre tid n en omvandling (ca 104 us) medfr att resultat
+*             hamnar p fel kanal.
+********************************************************************************/
+
+#ifndef ADC_SCAN_H_
+#define ADC_SCAN_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "adc.h"
+
+#ifndef ADC_SCAN_MAX_CHANNELS
+#define ADC_SCAN_MAX_CHANNELS 6 /* Max antal kanaler som kan registreras. */
+#endif
+
+#ifndef ADC_SCAN_BUFFER_SIZE
+#define ADC_SCAN_BUFFER_SIZE 8 /* Antal resultat som buffras per kanal, mste vara 2^n och max 256. */
+#endif
+
+#ifndef ADC_SCAN_DISCARD_FIRST
+#define ADC_SCAN_DISCARD_FIRST 1 /* 1 om frsta omvandlingen efter byte av kanal ska slngas. */
+#endif
+
+#if (ADC_SCAN_BUFFER_SIZE & (ADC_SCAN_BUFFER_SIZE - 1)) || ADC_SCAN_BUFFER_SIZE > 256
+#error "ADC_SCAN_BUFFER_SIZE mste vara 2^n och max 256!"
+#endif
+
+/********************************************************************************
+* adc_scan_channel: Strukt fr en kanal som lses av via adc_scan. Resultaten
+*                   lagras i en ringbuffert som fylls p frn ADC_vect. Om
+*                   bufferten r full slngs det nya resultatet, men det
+*                   senaste resultatet finns alltid tillgngligt via
+*                   adc_scan_latest.
+********************************************************************************/
+struct adc_scan_channel {
+	uint8_t pin;			/* pin: Analog pin som lses av. */
+	uint8_t divider;		/* divider: Kanalen lses av var divider:e varv. */
+	uint8_t countdown;		/* countdown: Antal varv kvar tills kanalen str p tur. */
+	volatile uint16_t buffer[ADC_SCAN_BUFFER_SIZE]; /* buffer: Ringbuffert med resultat. */
+	volatile uint8_t head;	/* head: Index dr nsta resultat lggs in. */
+	volatile uint8_t tail;	/* tail: Index fr nsta resultat som ska lsas. */
+	volatile uint16_t latest;	/* latest: Senaste resultatet. */
+	volatile uint16_t dropped;	/* dropped: Antal resultat slngda vid full buffert. */
+};
+
+/********************************************************************************
+* adc_scan_channel_init: Initierar kanal fr avlsning via adc_scan.
+*
+*                        - self   : Pekare till kanalen.
+*                        - pin    : Analog pin som ska lsas av.
+*                        - divider: Kanalen lses av var divider:e varv (minst 1).
+********************************************************************************/
+void adc_scan_channel_init(struct adc_scan_channel* self, 
+                           const uint8_t pin, 
+                           const uint8_t divider);
+
+/********************************************************************************
+* adc_scan_add: Lgger till kanal i listan ver kanaler som ska lsas av.
+*               Returnerar false om listan r full eller om avlsningen pgr.
+*
+*               - self: Pekare till kanalen som ska lggas till.
+********************************************************************************/
+bool adc_scan_add(struct adc_scan_channel* self);
+
+/********************************************************************************
+* adc_scan_start: Startar avlsning av registrerade kanaler. Returnerar false
+*                 om inga kanaler r registrerade eller om AD-omvandlaren
+*                 redan anvnds.
+********************************************************************************/
+bool adc_scan_start(void);
+
+/********************************************************************************
+* adc_scan_stop: Stoppar avlsningen och frigr AD-omvandlaren. Resultat som
+*                redan ligger i buffertarna kan fortfarande lsas av.
+********************************************************************************/
+void adc_scan_stop(void);
+
+/********************************************************************************
+* adc_scan_running: Indikerar ifall avlsningen pgr.
+********************************************************************************/
+bool adc_scan_running(void);
+
+/********************************************************************************
+* adc_scan_read: Lser ldsta olsta resultatet fr angiven kanal och lagrar
+*                det p angiven adress. Returnerar false om inget nytt
+*                resultat finns.
+*
+*                - self : Pekare till kanalen som ska lsas av.
+*                - value: Adress dr resultatet ska lagras.
+********************************************************************************/
+bool adc_scan_read(struct adc_scan_channel* self, uint16_t* value);
+
+/********************************************************************************
+* adc_scan_latest: Returnerar senaste resultatet fr angiven kanal utan att
+*                  pverka ringbufferten.
+*
+*                  - self: Pekare till kanalen.
+********************************************************************************/
+static inline uint16_t adc_scan_latest(const struct adc_scan_channel* self)
+{
+	uint16_t value;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		value = self->latest;
+	}
+	return value;
+}
+
+#endif /* ADC_SCAN_H_ */
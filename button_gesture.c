@@ -0,0 +1,152 @@
+/*
+ * button_gesture.c
+ */ 
+
+/********************************************************************************
+* button_gesture.c: Innehller funktionsdefinitioner fr tolkning av
+*                   knapptryck som gester.
+********************************************************************************/
+#include "button_gesture.h"
+#include <stddef.h>
+
+/* Statiska funktioner: */
+static void button_gesture_on_button(struct debounce* debounce, 
+                                     const bool pressed, 
+                                     const uint32_t time_us);
+static void button_gesture_on_timer(struct sw_timer* timer);
+static inline void button_gesture_emit(struct button_gesture* self, 
+                                       const enum button_gesture_type type);
+
+/********************************************************************************
+* button_gesture_init: Initierar gesttolkning fr angiven tryckknapp.
+*
+*                      - self    : Pekare till gesttolkningen som ska initieras.
+*                      - button  : Pekare till tryckknappen.
+*                      - callback: Funktion som anropas vid varje gest.
+********************************************************************************/
+void button_gesture_init(struct button_gesture* self, 
+                         struct button* button, 
+                         void (*callback)(struct button_gesture* self, 
+                                          const enum button_gesture_type type, 
+                                          const uint32_t press_us))
+{
+   self->state = BUTTON_GESTURE_IDLE;
+   self->press_us = 0;
+   self->callback = callback;
+   button_gesture_set_timing(self, BUTTON_GESTURE_DOUBLE_MS, 
+                             BUTTON_GESTURE_LONG_MS, BUTTON_GESTURE_REPEAT_MS);
+   sw_timer_init(&self->timer, button_gesture_on_timer);
+   debounce_init(&self->debounce, button, button_gesture_on_button);
+   return;
+}
+
+/********************************************************************************
+* button_gesture_on_button: Anropas frn main-loopen nr knappen har tryckts
+*                           ned eller slppts.
+*
+*                           1. Nedtryckning i vilolge startar en ny gest och
+*                              timern fr lngt tryck. Nedtryckning inom
+*                              double_ms efter ett klick rapporteras direkt
+*                              som dubbelklick.
+*
+*                           2. Slpp efter kort tryck startar timern fr
+*                              dubbelklick, eller rapporterar klick direkt om
+*                              dubbelklick r avstngt. Slpp efter lngt
+*                              tryck eller dubbelklick avslutar gesten.
+*
+*                           - debounce: Pekare till avstudsningen i gesten.
+*                           - pressed : true vid nedtryckning, false vid slpp.
+*                           - time_us : Tidpunkt fr flanken i mikrosekunder.
+********************************************************************************/
+static void button_gesture_on_button(struct debounce* debounce, 
+                                     const bool pressed, 
+                                     const uint32_t time_us)
+{
+   struct button_gesture* self = (struct button_gesture*)((uint8_t*)debounce - offsetof(struct button_gesture, debounce));
+
+   if (pressed)
+   {
+      if (self->state == BUTTON_GESTURE_RELEASED)
+      {
+         sw_timer_stop(&self->timer);
+         self->state = BUTTON_GESTURE_SECOND;
+         button_gesture_emit(self, BUTTON_GESTURE_DOUBLE);
+      }
+      else if (self->state == BUTTON_GESTURE_IDLE)
+      {
+         self->press_us = time_us;
+         self->state = BUTTON_GESTURE_PRESSED;
+         sw_timer_start_ms(&self->timer, self->long_ms, 0);
+      }
+   }
+   else if (self->state == BUTTON_GESTURE_PRESSED)
+   {
+      sw_timer_stop(&self->timer);
+
+      if (self->double_ms)
+      {
+         self->state = BUTTON_GESTURE_RELEASED;
+         sw_timer_start_ms(&self->timer, self->double_ms, 0);
+      }
+      else
+      {
+         self->state = BUTTON_GESTURE_IDLE;
+         button_gesture_emit(self, BUTTON_GESTURE_CLICK);
+      }
+   }
+   else if (self->state != BUTTON_GESTURE_RELEASED)
+   {
+      sw_timer_stop(&self->timer);
+      self->state = BUTTON_GESTURE_IDLE;
+   }
+   return;
+}
+
+/********************************************************************************
+* button_gesture_on_timer: Anropas nr timern fr gesten lper ut. Under
+*                          frsta nedtryckningen rapporteras lngt tryck och
+*                          upprepning startas, varefter varje period
+*                          rapporteras som upprepning. Efter ett kort tryck
+*                          har tiden fr dubbelklick lpt ut, s trycket
+*                          rapporteras som klick.
+*
+*                          - timer: Pekare till timern i gesten.
+********************************************************************************/
+static void button_gesture_on_timer(struct sw_timer* timer)
+{
+   struct button_gesture* self = (struct button_gesture*)((uint8_t*)timer - offsetof(struct button_gesture, timer));
+
+   if (self->state == BUTTON_GESTURE_PRESSED)
+   {
+      self->state = BUTTON_GESTURE_HELD;
+      if (self->repeat_ms)
+      {
+         sw_timer_start_ms(&self->timer, self->repeat_ms, self->repeat_ms);
+      }
+      button_gesture_emit(self, BUTTON_GESTURE_LONG);
+   }
+   else if (self->state == BUTTON_GESTURE_HELD)
+   {
+      button_gesture_emit(self, BUTTON_GESTURE_REPEAT);
+   }
+   else if (self->state == BUTTON_GESTURE_RELEASED)
+   {
+      self->state = BUTTON_GESTURE_IDLE;
+      button_gesture_emit(self, BUTTON_GESTURE_CLICK);
+   }
+   return;
+}
+
+/********************************************************************************
+* button_gesture_emit: Anropar callbacken med angiven gest, om en callback
+*                      r satt.
+*
+*                      - self: Pekare till gesttolkningen.
+*                      - type: Gesten som ska rapporteras.
+********************************************************************************/
+static inline void button_gesture_emit(struct button_gesture* self, 
+                                       const enum button_gesture_type type)
+{
+   if (self->callback) self->callback(self, type, self->press_us);
+   return;
+}
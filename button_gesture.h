@@ -0,0 +1,132 @@
+/*
+ * button_gesture.h
+ */ 
+
+/********************************************************************************
+* button_gesture.h: Innehller funktionalitet fr tolkning av knapptryck som
+*                   gester via strukten button_gesture. Knappen avstudsas via
+*                   debounce.h och tiderna mts med en mjukvarutimer per
+*                   knapp, s arbetet per knapp och tick r konstant och
+*                   applikationen behver varken polla knappen eller mta
+*                   tider sjlv.
+*
+*                   Fljande gester rapporteras via callback:
+*
+*                   - BUTTON_GESTURE_CLICK : Knappen trycktes och slpptes
+*                     innan long_ms, och ingen ny nedtryckning skedde inom
+*                     double_ms efter slppet.
+*
+*                   - BUTTON_GESTURE_DOUBLE: Knappen trycktes ned igen inom
+*                     double_ms efter ett klick. Rapporteras direkt vid andra
+*                     nedtryckningen.
+*
+*                   - BUTTON_GESTURE_LONG  : Knappen har hllits nedtryckt i
+*                     long_ms, rknat frn bekrftad nedtryckning.
+*
+*                   - BUTTON_GESTURE_REPEAT: Knappen hlls fortfarande
+*                     nedtryckt, rapporteras var repeat_ms efter LONG.
+*
+*                   Om double_ms r 0 rapporteras CLICK direkt vid slpp,
+*                   och om repeat_ms r 0 rapporteras endast LONG.
+********************************************************************************/
+#ifndef BUTTON_GESTURE_H_
+#define BUTTON_GESTURE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "debounce.h"
+
+#ifndef BUTTON_GESTURE_DOUBLE_MS
+#define BUTTON_GESTURE_DOUBLE_MS 300 /* Max tid frn slpp till ny nedtryckning vid dubbelklick. */
+#endif
+
+#ifndef BUTTON_GESTURE_LONG_MS
+#define BUTTON_GESTURE_LONG_MS 800 /* Tid som knappen ska hllas nedtryckt fr lngt tryck. */
+#endif
+
+#ifndef BUTTON_GESTURE_REPEAT_MS
+#define BUTTON_GESTURE_REPEAT_MS 200 /* Tid mellan upprepningar nr knappen hlls nedtryckt. */
+#endif
+
+/********************************************************************************
+* button_gesture_type: Gester som kan rapporteras.
+********************************************************************************/
+enum button_gesture_type
+{
+   BUTTON_GESTURE_CLICK,  /* Enkelklick. */
+   BUTTON_GESTURE_DOUBLE, /* Dubbelklick. */
+   BUTTON_GESTURE_LONG,   /* Lngt tryck. */
+   BUTTON_GESTURE_REPEAT  /* Upprepning under lngt tryck. */
+};
+
+/********************************************************************************
+* button_gesture_state: Tillstnd i gesttolkningen.
+********************************************************************************/
+enum button_gesture_state
+{
+   BUTTON_GESTURE_IDLE,     /* Knappen r slppt, ingen gest pgr. */
+   BUTTON_GESTURE_PRESSED,  /* Frsta nedtryckningen, vntar p slpp eller lngt tryck. */
+   BUTTON_GESTURE_RELEASED, /* Slppt efter kort tryck, vntar p dubbelklick. */
+   BUTTON_GESTURE_SECOND,   /* Andra nedtryckningen, vntar p slpp. */
+   BUTTON_GESTURE_HELD      /* Lngt tryck, upprepning pgr. */
+};
+
+/********************************************************************************
+* button_gesture: Strukt fr tolkning av knapptryck som gester.
+********************************************************************************/
+struct button_gesture
+{
+   struct debounce debounce;         /* Avstudsning av knappen. */
+   struct sw_timer timer;            /* Timer fr long_ms, double_ms och repeat_ms. */
+   enum button_gesture_state state;  /* Aktuellt tillstnd. */
+   uint32_t press_us;                /* Tidpunkt fr nedtryckningen som inledde gesten. */
+   uint16_t double_ms;               /* Max tid mellan klick vid dubbelklick, 0 = av. */
+   uint16_t long_ms;                 /* Tid fr lngt tryck. */
+   uint16_t repeat_ms;               /* Tid mellan upprepningar, 0 = av. */
+   void (*callback)(struct button_gesture* self, 
+                    const enum button_gesture_type type, 
+                    const uint32_t press_us); /* Anropas vid varje gest. */
+};
+
+/********************************************************************************
+* button_gesture_init: Initierar gesttolkning fr angiven tryckknapp, som
+*                      mste vara initierad via button_init. Tiderna stts
+*                      till BUTTON_GESTURE_DOUBLE_MS, BUTTON_GESTURE_LONG_MS
+*                      och BUTTON_GESTURE_REPEAT_MS.
+*
+*                      - self    : Pekare till gesttolkningen som ska initieras.
+*                      - button  : Pekare till tryckknappen.
+*                      - callback: Funktion som anropas frn main-loopen vid
+*                                  varje gest med tidpunkten fr
+*                                  nedtryckningen som inledde gesten, se
+*                                  timer_get_us.
+********************************************************************************/
+void button_gesture_init(struct button_gesture* self, 
+                         struct button* button, 
+                         void (*callback)(struct button_gesture* self, 
+                                          const enum button_gesture_type type, 
+                                          const uint32_t press_us));
+
+/********************************************************************************
+* button_gesture_set_timing: Stter tiderna fr gesttolkningen. ndringen
+*                            gller frn nsta tidsmtning.
+*
+*                            - self     : Pekare till gesttolkningen.
+*                            - double_ms: Max tid mellan klick vid dubbelklick,
+*                                         0 fr att stnga av dubbelklick.
+*                            - long_ms  : Tid fr lngt tryck, minst 1.
+*                            - repeat_ms: Tid mellan upprepningar, 0 fr att
+*                                         stnga av upprepning.
+********************************************************************************/
+static inline void button_gesture_set_timing(struct button_gesture* self, 
+                                             const uint16_t double_ms, 
+                                             const uint16_t long_ms, 
+                                             const uint16_t repeat_ms)
+{
+   self->double_ms = double_ms;
+   self->long_ms = long_ms ? long_ms : 1;
+   self->repeat_ms = repeat_ms;
+   return;
+}
+
+#endif /* BUTTON_GESTURE_H_ */
@@ -0,0 +1,196 @@
+/*
+ * command.c
+ */ 
+
+/********************************************************************************
+* command.c: Innehller funktionsdefinitioner fr mottagning och exekvering av
+*            textkommandon via USART.
+********************************************************************************/
+#include "command.h"
+#include <string.h>
+
+/* Statiska funktioner: */
+static void command_on_rx(const struct event* event);
+static void command_execute(const char* line);
+static bool command_parse_unsigned(const char* s, uint32_t* number);
+static void command_print_error(const char* reason);
+
+/********************************************************************************
+* command_init: Stter command_on_rx till att ta om hand hndelser av typen
+*               EVENT_RX.
+********************************************************************************/
+void command_init(void)
+{
+	event_set_handler(EVENT_RX, command_on_rx);
+	return;
+}
+
+/********************************************************************************
+* command_on_rx: Anropas frn main-loopen vid hndelse av typen EVENT_RX och
+*                lser av mottagningsbufferten via command_poll. Tecknet i
+*                hndelsen anvnds inte, eftersom command_poll lser samtliga
+*                tecken i bufferten. Efterfljande hndelser fr redan lsta
+*                tecken blir d tomma anrop. CPU:n hlls vaken i
+*                COMMAND_AWAKE_MS, s att resten av kommandot hinner tas
+*                emot ven om Power-down anvnds. Tecken som skickas medan
+*                CPU:n redan sover i Power-down gr dremot frlorade,
+*                se power.h.
+*
+*                - event: Hndelsen som ska tas om hand (anvnds ej).
+********************************************************************************/
+static void command_on_rx(const struct event* event)
+{
+	(void)event;
+	power_keep_awake(COMMAND_AWAKE_MS);
+	command_poll();
+	return;
+}
+
+/********************************************************************************
+* command_poll: Lser av mottagna tecken utan att vnta och exekverar ett
+*               kommando s fort en hel rad har tagits emot.
+*
+*               1. Vi hmtar alla tecken som finns i mottagningsbufferten via
+*                  funktionen serial_read_char.
+*
+*               2. Vid radbrytning avslutas raden med ett nolltecken och
+*                  exekveras, om den inte r tom. Om raden var fr lng
+*                  skickas i stllet ett felmeddelande.
+*
+*               3. Backsteg tar bort senast mottagna tecken, s att kommandon
+*                  ven kan skrivas fr hand i en terminal.
+*
+*               4. vriga tecken lggs till raden s lnge plats finns. Om
+*                  raden blir fr lng ignoreras resten fram till radbrytning.
+*
+*               - line       : Statisk buffert med mottagna tecken.
+*               - length     : Antal tecken lagrade i bufferten.
+*               - overflowed : Indikerar att raden var fr lng.
+********************************************************************************/
+void command_poll(void)
+{
+	static char line[COMMAND_LINE_SIZE];
+	static uint8_t length = 0;
+	static bool overflowed = false;
+	char c;
+
+	while (serial_read_char(&c))
+	{
+		if (c == '\r' || c == '\n')
+		{
+			line[length] = '\0';
+
+			if (overflowed)
+			{
+				command_print_error("line too long");
+			}
+			else if (length > 0)
+			{
+				command_execute(line);
+			}
+
+			length = 0;
+			overflowed = false;
+		}
+		else if (c == '\b' || c == 0x7F)
+		{
+			if (length > 0) length--;
+		}
+		else if (length < COMMAND_LINE_SIZE - 1)
+		{
+			line[length++] = c;
+		}
+		else
+		{
+			overflowed = true;
+		}
+	}
+	return;
+}
+
+/********************************************************************************
+* command_execute: Tolkar och exekverar angivet kommando. Om kommandot r
+*                  oknt eller argumentet ogiltigt skickas ett felmeddelande,
+*                  annars skickas "ok" efter eventuell utskrift.
+*
+*                  - line: Kommandot som ska exekveras, avslutat med nolltecken.
+********************************************************************************/
+static void command_execute(const char* line)
+{
+	if (strncmp(line, "period ", 7) == 0)
+	{
+		uint32_t period_ms;
+
+		if (!command_parse_unsigned(line + 7, &period_ms) ||
+		    period_ms < COMMAND_PERIOD_MIN_MS || period_ms > COMMAND_PERIOD_MAX_MS)
+		{
+			command_print_error("invalid period");
+			return;
+		}
+
+		temp_set_period(period_ms);
+	}
+	else if (strcmp(line, "stats") == 0)
+	{
+		temp_print_stats();
+	}
+	else if (strcmp(line, "raw on") == 0)
+	{
+		temp_set_raw_output(true);
+	}
+	else if (strcmp(line, "raw off") == 0)
+	{
+		temp_set_raw_output(false);
+	}
+	else if (strcmp(line, "report now") == 0)
+	{
+		temp_request_report();
+	}
+	else
+	{
+		command_print_error("unknown command");
+		return;
+	}
+
+	serial_print_string("ok\n");
+	return;
+}
+
+/********************************************************************************
+* command_parse_unsigned: Omvandlar angiven text till ett osignerat heltal.
+*                         Texten fr endast innehlla siffror och talet fr
+*                         inte verstiga 32 bitar, annars returneras false.
+*
+*                         - s     : Texten som ska omvandlas.
+*                         - number: Pekare till variabel dr talet lagras.
+********************************************************************************/
+static bool command_parse_unsigned(const char* s, uint32_t* number)
+{
+	uint32_t value = 0;
+
+	if (*s == '\0') return false;
+
+	for (; *s; ++s)
+	{
+		if (*s < '0' || *s > '9') return false;
+		const uint8_t digit = *s - '0';
+		if (value > (UINT32_MAX - digit) / 10) return false;
+		value = value * 10 + digit;
+	}
+
+	*number = value;
+	return true;
+}
+
+/********************************************************************************
+* command_print_error: Skickar ett felmeddelande med angiven orsak.
+*
+*                      - reason: Orsaken till felet.
+********************************************************************************/
+static void command_print_error(const char* reason)
+{
+	serial_print_string("error: ");
+	serial_print_string(reason);
+	serial_print_new_line();
+	return;
+}
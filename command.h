@@ -0,0 +1,49 @@
+/*
+ * command.h
+ */ 
+
+/********************************************************************************
+* command.h: Innehller funktionalitet fr att ta emot textkommandon via USART
+*            och konfigurera systemet medan det kr, exempelvis frn ett skript
+*            p en vrddator. Varje kommando avslutas med radbrytning (\r
+*            eller \n). Fljande kommandon stds:
+*
+*            Kommando         Beskrivning
+*            period <ms>      Stter ny mtfrekvens mtt i millisekunder.
+*            stats            Skriver ut statistik fr mtning och verfring.
+*            raw on/off       Aktiverar/inaktiverar utskrift av ra AD-vrden.
+*            report now       Lser in och skriver ut temperaturen direkt.
+*
+*            Efter varje kommando skickas "ok" eller "error: <orsak>".
+********************************************************************************/
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+#include "temp_sensor.h"
+
+/* Makrodefinitioner: */
+#define COMMAND_LINE_SIZE 24         /* Maximalt antal tecken per kommando inklusive nolltecken. */
+#define COMMAND_PERIOD_MIN_MS 100UL  /* Minsta tilltna mtfrekvens mtt i millisekunder. */
+#define COMMAND_PERIOD_MAX_MS 86400000UL /* Strsta tilltna mtfrekvens (ett dygn) mtt i millisekunder. */
+#define COMMAND_AWAKE_MS 10000UL     /* Tid som CPU:n hlls vaken efter mottaget tecken. */
+
+/********************************************************************************
+* command_init: Stter funktion som tar om hand hndelser av typen EVENT_RX,
+*               s att mottagna tecken lses av via command_poll frn
+*               main-loopen s fort de har tagits emot.
+********************************************************************************/
+void command_init(void);
+
+/********************************************************************************
+* command_poll: Lser av mottagna tecken utan att vnta och exekverar ett
+*               kommando s fort en hel rad har tagits emot. Anropas frn
+*               main-loopen vid hndelse av typen EVENT_RX, men kan ven
+*               anropas direkt.
+********************************************************************************/
+void command_poll(void);
+
+#endif /* COMMAND_H_ */
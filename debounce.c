@@ -0,0 +1,183 @@
+/*
+ * debounce.c
+ */ 
+
+/********************************************************************************
+* debounce.c: Innehller funktionsdefinitioner fr avbrottsstyrd avstudsning
+*             av tryckknappar.
+********************************************************************************/
+#include "debounce.h"
+#include <stddef.h>
+
+/* Statiska variabler: */
+static struct debounce* debounce_list = 0; /* Frsta avstudsade knappen, eller 0 om ingen. */
+
+/* Statiska funktioner: */
+static void debounce_on_event(const struct event* event);
+static void debounce_on_timer(struct sw_timer* timer);
+static void debounce_on_edge(const enum io_port port);
+static volatile uint8_t* debounce_mask(const struct debounce* self);
+
+/********************************************************************************
+* debounce_init: Initierar avstudsning av angiven tryckknapp och lgger till
+*                den i listan, som gs igenom av PCI-avbrottsrutinerna.
+*
+*                - self    : Pekare till avstudsningen som ska initieras.
+*                - button  : Pekare till tryckknappen som ska avstudsas.
+*                - callback: Funktion som anropas vid nedtryckning och slpp.
+********************************************************************************/
+void debounce_init(struct debounce* self, 
+                   struct button* button, 
+                   void (*callback)(struct debounce* self, 
+                                    const bool pressed, 
+                                    const uint32_t time_us))
+{
+   self->button = button;
+   self->pressed = button_is_pressed(button);
+   self->settling = false;
+   self->edge_us = 0;
+   self->callback = callback;
+   sw_timer_init(&self->timer, debounce_on_timer);
+   event_set_handler(EVENT_BUTTON, debounce_on_event);
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      self->next = debounce_list;
+      debounce_list = self;
+   }
+
+   button_aktivate_interupts(button);
+   return;
+}
+
+/********************************************************************************
+* debounce_on_event: Anropas frn main-loopen vid hndelse av typen
+*                    EVENT_BUTTON och startar timern fr bekrftelse av
+*                    knappens lge.
+*
+*                    - event: Hndelsen, dr source pekar p avstudsningen.
+********************************************************************************/
+static void debounce_on_event(const struct event* event)
+{
+   struct debounce* self = event->source;
+   sw_timer_start_ms(&self->timer, DEBOUNCE_CONFIRM_MS, 0);
+   return;
+}
+
+/********************************************************************************
+* debounce_on_timer: Anropas nr insvngningstiden har lpt ut.
+*
+*                    1. Med avbrott inaktiverade lser vi av knappen och
+*                       aktiverar PCI-avbrottet p knappens pin igen.
+*
+*                    2. Om lget skiljer sig frn senast bekrftade lge
+*                       sparas det nya lget och callbacken anropas med
+*                       tidsstmpeln fr frsta flanken. Annars var flanken
+*                       en strning och ignoreras.
+*
+*                    3. Eftersom en flank mellan avlsningen och aktiveringen
+*                       av avbrottet inte skulle ge ngot avbrott lses
+*                       knappen av igen. Om lget har ndrats behandlas det
+*                       som en ny flank.
+*
+*                    - timer: Pekare till timern i avstudsningen.
+********************************************************************************/
+static void debounce_on_timer(struct sw_timer* timer)
+{
+   struct debounce* self = (struct debounce*)((uint8_t*)timer - offsetof(struct debounce, timer));
+   bool pressed, changed, edge = false;
+   uint32_t edge_us;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      pressed = button_is_pressed(self->button);
+      *debounce_mask(self) |= (1 << self->button->pin);
+      self->settling = false;
+      changed = pressed != self->pressed;
+      self->pressed = pressed;
+      edge_us = self->edge_us;
+
+      if (button_is_pressed(self->button) != pressed)
+      {
+         *debounce_mask(self) &= ~(1 << self->button->pin);
+         self->settling = true;
+         self->edge_us = timer_get_us();
+         edge = true;
+      }
+   }
+
+   if (changed && self->callback) self->callback(self, pressed, edge_us);
+   if (edge) sw_timer_start_ms(&self->timer, DEBOUNCE_CONFIRM_MS, 0);
+   return;
+}
+
+/********************************************************************************
+* debounce_on_edge: Anropas frn PCI-avbrottsrutinen fr angiven I/O-port.
+*                   Tiden lses av frst, s att tidsstmpeln ligger s nra
+*                   flanken som mjligt. Fr varje knapp p porten som inte
+*                   redan svnger in och vars pin har ndrats sedan senast
+*                   bekrftade lge skickas en hndelse. Frst nr den har
+*                   kats inaktiveras PCI-avbrottet p pinnen och flanken
+*                   tidsstmplas. Om kn r full frblir avbrottet aktivt,
+*                   s att nsta flank gr ett nytt frsk i stllet fr
+*                   att knappen frblir maskad.
+*
+*                   - port: I/O-porten vars avbrottsrutin anropade funktionen.
+********************************************************************************/
+static void debounce_on_edge(const enum io_port port)
+{
+   const uint32_t now_us = timer_get_us();
+
+   for (struct debounce* self = debounce_list; self; self = self->next)
+   {
+      if (self->button->io_port_button != port || self->settling) continue;
+      if (button_is_pressed(self->button) == self->pressed) continue;
+
+      if (!event_post(EVENT_BUTTON, 0, self)) continue;
+
+      *debounce_mask(self) &= ~(1 << self->button->pin);
+      self->settling = true;
+      self->edge_us = now_us;
+   }
+   return;
+}
+
+/********************************************************************************
+* debounce_mask: Returnerar adressen till maskregistret PCMSKn fr knappens
+*                I/O-port, se button_aktivate_interupts.
+*
+*                - self: Pekare till avstudsningen.
+********************************************************************************/
+static volatile uint8_t* debounce_mask(const struct debounce* self)
+{
+   if (self->button->io_port_button == IO_PORTB) return &PCMSK0;
+   else if (self->button->io_port_button == IO_PORTC) return &PCMSK1;
+   else return &PCMSK2;
+}
+
+/********************************************************************************
+* ISR (PCINT0_vect): Avbrottsrutin fr flanker p I/O-port B.
+********************************************************************************/
+ISR (PCINT0_vect)
+{
+   debounce_on_edge(IO_PORTB);
+   return;
+}
+
+/********************************************************************************
+* ISR (PCINT1_vect): Avbrottsrutin fr flanker p I/O-port C.
+********************************************************************************/
+ISR (PCINT1_vect)
+{
+   debounce_on_edge(IO_PORTC);
+   return;
+}
+
+/********************************************************************************
+* ISR (PCINT2_vect): Avbrottsrutin fr flanker p I/O-port D.
+********************************************************************************/
+ISR (PCINT2_vect)
+{
+   debounce_on_edge(IO_PORTD);
+   return;
+}
@@ -0,0 +1,83 @@
+/*
+ * debounce.h
+ */ 
+
+/********************************************************************************
+* debounce.h: Innehller funktionalitet fr avbrottsstyrd avstudsning av
+*             tryckknappar via strukten debounce.
+*
+*             Varje avstudsad knapp befinner sig i ngot av tv tillstnd:
+*
+*             - Stabil: PCI-avbrott r aktiverat p knappens pin. Ingen kod
+*               exekverar s lnge knappen inte ndrar lge.
+*
+*             - Insvngning: Vid frsta flanken tidsstmplas flanken via
+*               timer_get_us, PCI-avbrottet p knappens pin inaktiveras s
+*               att kontaktstudsar inte ger fler avbrott, och en hndelse av
+*               typen EVENT_BUTTON skickas till main-loopen, som startar en
+*               mjukvarutimer p DEBOUNCE_CONFIRM_MS ms. Nr timern lper ut
+*               lses knappen av. Om lget skiljer sig frn senast bekrftade
+*               lge anropas callbacken med nytt lge och tidsstmpeln fr
+*               frsta flanken, varefter PCI-avbrottet aktiveras igen.
+*
+*             Avbrottsrutinerna PCINT0_vect - PCINT2_vect definieras hr och
+*             fr drfr inte definieras p annat hll.
+********************************************************************************/
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "button.h"
+#include "event.h"
+#include "sw_timer.h"
+
+#ifndef DEBOUNCE_CONFIRM_MS
+#define DEBOUNCE_CONFIRM_MS 20 /* Tid frn frsta flanken tills knappens lge bekrftas, mtt i ms. */
+#endif
+
+/********************************************************************************
+* debounce: Strukt fr avstudsning av en tryckknapp.
+********************************************************************************/
+struct debounce
+{
+   struct button* button;       /* Tryckknappen som avstudsas. */
+   volatile bool pressed;       /* Senast bekrftade lge. */
+   volatile bool settling;      /* Indikerar att en flank vntar p bekrftelse. */
+   volatile uint32_t edge_us;   /* Tidsstmpel fr frsta flanken mtt i mikrosekunder. */
+   struct sw_timer timer;       /* Timer fr bekrftelse av knappens lge. */
+   void (*callback)(struct debounce* self, 
+                    const bool pressed, 
+                    const uint32_t time_us); /* Anropas vid nedtryckning och slpp. */
+   struct debounce* next;       /* Nsta avstudsade knapp i listan. */
+};
+
+/********************************************************************************
+* debounce_init: Initierar avstudsning av angiven tryckknapp, som mste vara
+*                initierad via button_init. Knappens aktuella lge blir
+*                startlge, varefter PCI-avbrott aktiveras p knappens pin.
+*
+*                - self    : Pekare till avstudsningen som ska initieras.
+*                - button  : Pekare till tryckknappen som ska avstudsas.
+*                - callback: Funktion som anropas frn main-loopen vid
+*                            bekrftad nedtryckning (pressed = true) och
+*                            slpp (pressed = false) med tidsstmpel fr
+*                            flanken, se timer_get_us.
+********************************************************************************/
+void debounce_init(struct debounce* self, 
+                   struct button* button, 
+                   void (*callback)(struct debounce* self, 
+                                    const bool pressed, 
+                                    const uint32_t time_us));
+
+/********************************************************************************
+* debounce_is_pressed: Returnerar senast bekrftade lge fr angiven knapp.
+*
+*                      - self: Pekare till avstudsningen.
+********************************************************************************/
+static inline bool debounce_is_pressed(const struct debounce* self)
+{
+   return self->pressed;
+}
+
+#endif /* DEBOUNCE_H_ */
@@ -0,0 +1,136 @@
+/*
+ * event.c
+ */ 
+
+/********************************************************************************
+* event.c: Innehller funktionsdefinitioner fr att skicka hndelser frn
+*          avbrottsrutiner till main-loopen.
+********************************************************************************/
+#include "event.h"
+
+/* Makrodefinitioner: */
+#define EVENT_MASK (EVENT_QUEUE_SIZE - 1) /* Mask fr index i ringbufferten. */
+
+/********************************************************************************
+* EVENT_BARRIER: Kompilatorbarrir. Bufferten r inte volatile, s utan
+*                barriren fr kompilatorn flytta lsningar och skrivningar
+*                av hndelsen frbi skrivningen av head eller tail, som r
+*                volatile. ATmega328P exekverar i programordning, s ingen
+*                instruktion behvs.
+********************************************************************************/
+#define EVENT_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/********************************************************************************
+* event_queue: Ringbuffert med hndelser av en typ. head skrivs endast av
+*              avbrottsrutinen och tail endast av main-loopen.
+********************************************************************************/
+struct event_queue
+{
+   struct event buffer[EVENT_QUEUE_SIZE]; /* Hndelser i kn. */
+   volatile uint8_t head;                 /* Index dr nsta hndelse lggs in. */
+   volatile uint8_t tail;                 /* Index fr nsta hndelse som ska tas om hand. */
+};
+
+/* Statiska variabler: */
+static struct event_queue event_queues[EVENT_TYPE_COUNT];                       /* En k per typ av hndelse. */
+static void (*event_handlers[EVENT_TYPE_COUNT])(const struct event* event);     /* Funktion per typ av hndelse. */
+static volatile uint16_t event_dropped_count = 0;                               /* Antal slngda hndelser. */
+
+/********************************************************************************
+* event_set_handler: Stter funktion som ska anropas fr varje hndelse av
+*                    angiven typ.
+*
+*                    - type   : Typ av hndelse.
+*                    - handler: Funktion som ska anropas, eller 0 fr ingen.
+********************************************************************************/
+void event_set_handler(const enum event_type type, 
+                       void (*handler)(const struct event* event))
+{
+   if (type < EVENT_TYPE_COUNT) event_handlers[type] = handler;
+   return;
+}
+
+/********************************************************************************
+* event_post: Lgger en hndelse i kn fr angiven typ. Hndelsen skrivs till
+*             bufferten innan head rknas upp, vilket skerstlls med
+*             EVENT_BARRIER, s att main-loopen aldrig kan lsa en
+*             ofullstndig hndelse.
+*
+*             - type  : Typ av hndelse.
+*             - data  : Data som hr till hndelsen.
+*             - source: Pekare till objektet som skickade hndelsen (eller 0).
+********************************************************************************/
+bool event_post(const enum event_type type, 
+                const uint16_t data, 
+                void* source)
+{
+   struct event_queue* queue = &event_queues[type];
+   const uint8_t head = queue->head;
+   const uint8_t next = (head + 1) & EVENT_MASK;
+
+   if (next == queue->tail)
+   {
+      event_dropped_count++;
+      return false;
+   }
+
+   queue->buffer[head].type = type;
+   queue->buffer[head].data = data;
+   queue->buffer[head].source = source;
+   EVENT_BARRIER();
+   queue->head = next;
+   return true;
+}
+
+/********************************************************************************
+* event_dispatch: Gr igenom kerna och tar om hand varje hndelse genom att
+*                 kopiera den, rkna upp tail s att platsen frigrs och
+*                 drefter anropa funktionen fr hndelsens typ. Kopieringen
+*                 avslutas fre tail rknas upp via EVENT_BARRIER, s att en
+*                 avbrottsrutin inte kan skriva ver platsen medan den lses.
+********************************************************************************/
+void event_dispatch(void)
+{
+   for (uint8_t type = 0; type < EVENT_TYPE_COUNT; ++type)
+   {
+      struct event_queue* queue = &event_queues[type];
+
+      while (queue->tail != queue->head)
+      {
+         const uint8_t tail = queue->tail;
+         const struct event event = queue->buffer[tail];
+         EVENT_BARRIER();
+         queue->tail = (tail + 1) & EVENT_MASK;
+         if (event_handlers[type]) event_handlers[type](&event);
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* event_pending: Indikerar ifall ngon k innehller hndelser som inte har
+*                tagits om hand.
+********************************************************************************/
+bool event_pending(void)
+{
+   for (uint8_t type = 0; type < EVENT_TYPE_COUNT; ++type)
+   {
+      if (event_queues[type].tail != event_queues[type].head) return true;
+   }
+   return false;
+}
+
+/********************************************************************************
+* event_dropped: Returnerar antalet slngda hndelser. Eftersom rknaren r
+*                16 bitar och rknas upp i avbrottsrutiner lses den med
+*                avbrott inaktiverade.
+********************************************************************************/
+uint16_t event_dropped(void)
+{
+   uint16_t dropped;
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      dropped = event_dropped_count;
+   }
+   return dropped;
+}
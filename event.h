@@ -0,0 +1,100 @@
+/*
+ * event.h
+ */ 
+
+/********************************************************************************
+* event.h: Innehller funktionalitet fr att skicka hndelser (events) frn
+*          avbrottsrutiner till main-loopen, dr de tas om hand. Avbrotts-
+*          rutinerna blir d korta, eftersom de endast lgger in en hndelse
+*          i en k, medan arbetet (exempelvis berkningar och utskrifter)
+*          sker i main-loopen via funktionen event_dispatch.
+*
+*          Varje typ av hndelse har en egen k i form av en ringbuffert med
+*          8-bitars index. Eftersom varje typ endast skickas frn en avbrotts-
+*          rutin (en producent) och endast lses frn main-loopen (en
+*          konsument) behver avbrott inte inaktiveras, d varje index endast
+*          skrivs av en part och 8-bitars lsning och skrivning r atomr.
+*          Hndelser av samma typ tas om hand i den ordning de skickades.
+********************************************************************************/
+
+#ifndef EVENT_H_
+#define EVENT_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 8 /* Antal hndelser per k, mste vara 2^n och max 256. */
+#endif
+
+#if (EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) || EVENT_QUEUE_SIZE > 256
+#error "EVENT_QUEUE_SIZE mste vara 2^n och max 256!"
+#endif
+
+/********************************************************************************
+* event_type: Enumeration fr typ av hndelse. Varje typ fr endast skickas
+*             frn en avbrottsrutin.
+********************************************************************************/
+enum event_type
+{
+   EVENT_TICK,      /* Systemtick, skickas frn TIMER1_COMPA_vect. */
+   EVENT_BUTTON,    /* Frsta flanken p avstudsad knapp, skickas frn PCI-avbrott (se debounce.h). */
+   EVENT_ADC,       /* AD-omvandling klar, skickas frn ADC_vect. */
+   EVENT_RX,        /* Tecken mottaget, skickas frn USART_RX_vect. */
+   EVENT_TYPE_COUNT /* Antal typer av hndelser. */
+};
+
+/********************************************************************************
+* event: Strukt fr en hndelse.
+********************************************************************************/
+struct event
+{
+   uint8_t type;  /* Typ av hndelse, se event_type. */
+   uint16_t data; /* Data som hr till hndelsen, exempelvis mottaget tecken. */
+   void* source;  /* Pekare till objektet som skickade hndelsen (eller 0). */
+};
+
+/********************************************************************************
+* event_set_handler: Stter funktion som ska anropas frn main-loopen fr
+*                    varje hndelse av angiven typ.
+*
+*                    - type   : Typ av hndelse.
+*                    - handler: Funktion som ska anropas, eller 0 fr ingen.
+********************************************************************************/
+void event_set_handler(const enum event_type type, 
+                       void (*handler)(const struct event* event));
+
+/********************************************************************************
+* event_post: Lgger en hndelse i kn fr angiven typ. Anropas frn den
+*             avbrottsrutin som ger typen. Returnerar false om kn r full,
+*             varvid hndelsen slngs.
+*
+*             - type  : Typ av hndelse.
+*             - data  : Data som hr till hndelsen.
+*             - source: Pekare till objektet som skickade hndelsen (eller 0).
+********************************************************************************/
+bool event_post(const enum event_type type, 
+                const uint16_t data, 
+                void* source);
+
+/********************************************************************************
+* event_dispatch: Tar om hand samtliga hndelser som ligger i kerna genom
+*                 att anropa motsvarande funktion. Ska anropas kontinuerligt
+*                 frn main-loopen.
+********************************************************************************/
+void event_dispatch(void);
+
+/********************************************************************************
+* event_pending: Indikerar ifall ngon hndelse vntar p att tas om hand.
+*                Anvnds innan CPU:n frstts i vilolge, med avbrott
+*                inaktiverade.
+********************************************************************************/
+bool event_pending(void);
+
+/********************************************************************************
+* event_dropped: Returnerar antalet hndelser som har slngts p grund av
+*                full k sedan start.
+********************************************************************************/
+uint16_t event_dropped(void);
+
+#endif /* EVENT_H_ */
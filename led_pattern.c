@@ -0,0 +1,162 @@
+/*
+ * led_pattern.c
+ */ 
+
+/********************************************************************************
+* led_pattern.c: Innehller funktionsdefinitioner fr icke-blockerande
+*                blinkmnster p lysdioder lagrade i en led_vect.
+********************************************************************************/
+#include "led_pattern.h"
+#include <stddef.h>
+
+/* Statiska funktioner: */
+static void led_pattern_on_timer(struct sw_timer* timer);
+static void led_pattern_show(struct led_pattern* self);
+
+/********************************************************************************
+* led_pattern_init: Initierar mnster fr angiven vektor.
+*
+*                   - self: Pekare till mnstret som ska initieras.
+*                   - vect: Pekare till vektorn vars lysdioder ska styras.
+********************************************************************************/
+void led_pattern_init(struct led_pattern* self, struct led_vect* vect)
+{
+   self->vect = vect;
+   self->type = LED_PATTERN_SEQUENTIAL;
+   self->step = 0;
+   self->reverse = false;
+   sw_timer_init(&self->timer, led_pattern_on_timer);
+   return;
+}
+
+/********************************************************************************
+* led_pattern_start: Startar uppspelning av angivet mnster. Steg kortare n
+*                    en systemtick, inklusive step_ms = 0, stts till en
+*                    systemtick, eftersom periodtiden 0 skulle gra timern
+*                    till en one-shot och stoppa mnstret efter frsta steget.
+*
+*                    - self   : Pekare till mnstret.
+*                    - type   : Mnstret som ska spelas.
+*                    - step_ms: Tid per steg mtt i millisekunder.
+********************************************************************************/
+void led_pattern_start(struct led_pattern* self, 
+                       const enum led_pattern_type type, 
+                       const uint16_t step_ms)
+{
+   uint32_t step_ticks = timer_get_max_count(step_ms);
+   if (!step_ticks) step_ticks = 1;
+
+   sw_timer_stop(&self->timer);
+   self->type = type;
+   self->step = 0;
+   self->reverse = false;
+
+   led_vect_off(self->vect);
+   led_pattern_show(self);
+   sw_timer_start(&self->timer, step_ticks, step_ticks);
+   return;
+}
+
+/********************************************************************************
+* led_pattern_stop: Stoppar uppspelningen och slcker samtliga lysdioder.
+*
+*                   - self: Pekare till mnstret.
+********************************************************************************/
+void led_pattern_stop(struct led_pattern* self)
+{
+   sw_timer_stop(&self->timer);
+   led_vect_off(self->vect);
+   return;
+}
+
+/********************************************************************************
+* led_pattern_on_timer: Anropas en gng per steg. Aktuell lysdiod slcks vid
+*                       sekventiella mnster, varefter nsta steg berknas
+*                       och visas.
+*
+*                       1. LED_PATTERN_SEQUENTIAL stegar framt och brjar
+*                          om frn frsta lysdioden efter den sista.
+*
+*                       2. LED_PATTERN_CHASE byter riktning vid vektorns
+*                          ndar, s ndarnas lysdioder visas en gng per varv.
+*
+*                       3. LED_PATTERN_HEARTBEAT stegar genom
+*                          LED_PATTERN_HEARTBEAT_STEPS steg.
+*
+*                       4. LED_PATTERN_COLLECTIVE har endast ett tillstnd.
+*
+*                       Om vektorn har krympt sedan frra steget slcks
+*                       vektorn och sekventiella mnster brjar om framt
+*                       frn frsta lysdioden.
+*
+*                       - timer: Pekare till timern i mnstret.
+********************************************************************************/
+static void led_pattern_on_timer(struct sw_timer* timer)
+{
+   struct led_pattern* self = (struct led_pattern*)((uint8_t*)timer - offsetof(struct led_pattern, timer));
+   const uint8_t size = self->vect->size;
+
+   if (!size) return;
+
+   if (self->step >= size && self->type != LED_PATTERN_HEARTBEAT)
+   {
+      led_vect_off(self->vect);
+      self->step = 0;
+      self->reverse = false;
+      led_pattern_show(self);
+      return;
+   }
+
+   if (self->type == LED_PATTERN_SEQUENTIAL)
+   {
+      led_off(&self->vect->leds[self->step]);
+      if (++self->step >= size) self->step = 0;
+   }
+   else if (self->type == LED_PATTERN_CHASE)
+   {
+      led_off(&self->vect->leds[self->step]);
+
+      if (size == 1) self->step = 0;
+      else if (self->reverse)
+      {
+         if (--self->step == 0) self->reverse = false;
+      }
+      else if (++self->step >= size - 1)
+      {
+         self->step = size - 1;
+         self->reverse = true;
+      }
+   }
+   else if (self->type == LED_PATTERN_HEARTBEAT)
+   {
+      if (++self->step >= LED_PATTERN_HEARTBEAT_STEPS) self->step = 0;
+   }
+
+   led_pattern_show(self);
+   return;
+}
+
+/********************************************************************************
+* led_pattern_show: Visar aktuellt steg i mnstret.
+*
+*                   - self: Pekare till mnstret.
+********************************************************************************/
+static void led_pattern_show(struct led_pattern* self)
+{
+   if (!self->vect->size) return;
+
+   if (self->type == LED_PATTERN_SEQUENTIAL || self->type == LED_PATTERN_CHASE)
+   {
+      led_on(&self->vect->leds[self->step]);
+   }
+   else if (self->type == LED_PATTERN_COLLECTIVE)
+   {
+      led_vect_toggle(self->vect);
+   }
+   else if (self->type == LED_PATTERN_HEARTBEAT)
+   {
+      if (self->step == 0 || self->step == 2) led_vect_on(self->vect);
+      else led_vect_off(self->vect);
+   }
+   return;
+}
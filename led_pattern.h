@@ -0,0 +1,101 @@
+/*
+ * led_pattern.h
+ */ 
+
+/********************************************************************************
+* led_pattern.h: Innehller funktionalitet fr icke-blockerande blinkmnster
+*                p lysdioder lagrade i en led_vect via strukten led_pattern.
+*
+*                Varje mnster r en tillstndsmaskin som stegas fram av en
+*                periodisk mjukvarutimer, s CPU:n r ledig mellan stegen och
+*                varje steg kostar endast ngra f instruktioner. Flera
+*                mnster kan spelas samtidigt p olika vektorer.
+*
+*                Fljande mnster finns:
+*
+*                - LED_PATTERN_SEQUENTIAL: En lysdiod i taget tnds i ordning,
+*                  varefter sekvensen brjar om.
+*
+*                - LED_PATTERN_COLLECTIVE: Samtliga lysdioder blinkar
+*                  samtidigt.
+*
+*                - LED_PATTERN_CHASE     : En lysdiod i taget tnds fram och
+*                  tillbaka lngs vektorn.
+*
+*                - LED_PATTERN_HEARTBEAT : Samtliga lysdioder blinkar tv
+*                  gnger kort fljt av en paus, som ett hjrtslag.
+********************************************************************************/
+#ifndef LED_PATTERN_H_
+#define LED_PATTERN_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led_vect.h"
+#include "sw_timer.h"
+
+#define LED_PATTERN_HEARTBEAT_STEPS 8 /* Antal steg per hjrtslag, lysdioderna tnds i steg 0 och 2. */
+
+/********************************************************************************
+* led_pattern_type: Blinkmnster som kan spelas.
+********************************************************************************/
+enum led_pattern_type
+{
+   LED_PATTERN_SEQUENTIAL, /* En lysdiod i taget i ordning. */
+   LED_PATTERN_COLLECTIVE, /* Samtliga lysdioder blinkar samtidigt. */
+   LED_PATTERN_CHASE,      /* En lysdiod i taget fram och tillbaka. */
+   LED_PATTERN_HEARTBEAT   /* Tv korta blinkningar fljt av paus. */
+};
+
+/********************************************************************************
+* led_pattern: Strukt fr uppspelning av blinkmnster p en vektor.
+********************************************************************************/
+struct led_pattern
+{
+   struct led_vect* vect;      /* Vektorn vars lysdioder styrs. */
+   enum led_pattern_type type; /* Mnstret som spelas. */
+   uint8_t step;               /* Aktuellt steg i mnstret. */
+   bool reverse;               /* Indikerar att LED_PATTERN_CHASE gr bakt. */
+   struct sw_timer timer;      /* Periodisk timer som stegar mnstret. */
+};
+
+/********************************************************************************
+* led_pattern_init: Initierar mnster fr angiven vektor. Inget mnster
+*                   spelas frrn led_pattern_start anropas.
+*
+*                   - self: Pekare till mnstret som ska initieras.
+*                   - vect: Pekare till vektorn vars lysdioder ska styras.
+********************************************************************************/
+void led_pattern_init(struct led_pattern* self, struct led_vect* vect);
+
+/********************************************************************************
+* led_pattern_start: Startar uppspelning av angivet mnster. Samtliga
+*                    lysdioder slcks frst och frsta steget visas direkt.
+*                    Ett mnster som redan spelas erstts.
+*
+*                    - self   : Pekare till mnstret.
+*                    - type   : Mnstret som ska spelas.
+*                    - step_ms: Tid per steg mtt i millisekunder, minst en
+*                               systemtick (0 ger en systemtick).
+********************************************************************************/
+void led_pattern_start(struct led_pattern* self, 
+                       const enum led_pattern_type type, 
+                       const uint16_t step_ms);
+
+/********************************************************************************
+* led_pattern_stop: Stoppar uppspelningen och slcker samtliga lysdioder.
+*
+*                   - self: Pekare till mnstret.
+********************************************************************************/
+void led_pattern_stop(struct led_pattern* self);
+
+/********************************************************************************
+* led_pattern_active: Indikerar ifall angivet mnster spelas.
+*
+*                     - self: Pekare till mnstret.
+********************************************************************************/
+static inline bool led_pattern_active(const struct led_pattern* self)
+{
+   return sw_timer_active(&self->timer);
+}
+
+#endif /* LED_PATTERN_H_ */
@@ -6,94 +6,113 @@
  */ 
 
 /********************************************************************************
-* led_vect.c: Innehller funktionsdefinitioner fr implementering av dynamiska
-*               vektorer fr lagring och styrning ver multipla lysdioder eller
+* led_vect.c: Innehller funktionsdefinitioner fr implementering av vektorer
+*               med fast kapacitet fr lagring och styrning ver multipla lysdioder eller
 *               andra utportar via strukten led_vect.
 ********************************************************************************/
 
 #include "led_vect.h"
 
+/* Statiska funktioner: */
+static inline uint8_t* led_vect_mask(struct led_vect* self, const struct led* led);
+
 /********************************************************************************
-* led_vect_init: Initierar angiven vektor till tom vid start.
+* led_vect_init: Initierar angiven vektor till tom vid start med angiven
+*                array som lagring.
 *
-*                - self: Pekare till vektorn som ska initieras.
+*                - self    : Pekare till vektorn som ska initieras.
+*                - leds    : Pekare till array som led-objekten lagras i.
+*                - capacity: Arrayens storlek, dvs. max antal led-objekt.
 ********************************************************************************/
-void led_vect_init(struct led_vect* self){
+void led_vect_init(struct led_vect* self, struct led* leds, uint8_t capacity){
 	
-	self->leds = 0;
+	self->leds = leds;
 	self->size = 0;
+	self->capacity = capacity;
+	self->mask_b = 0;
+	self->mask_d = 0;
 	return;
 }
 
 /********************************************************************************
-* led_vect_push: Lgger till ett nytt led-objekt lngst bak i angiven vektor.
-*                Vid misslyckad minnesallokering returneras felkod 1.
-*                Annars om push-operationen lyckas returneras 0.
+* led_vect_push: Lgger till en kopia av ett led-objekt lngst bak i angiven
+*                vektor och pinnen till bitmasken fr lysdiodens I/O-port.
+*                Om vektorn r full eller redan innehller en lysdiod p
+*                samma pin returneras felkod 1, annars 0.
 *
-*                - self*   : Pekare till vektorn som ska tilldelas.
-*                - led_ptr*: Det nya led-objekt som ska lggas till.
+*                - self   : Pekare till vektorn som ska tilldelas.
+*                - new_led: Pekare till led-objektet som ska lggas till.
 ********************************************************************************/
-void led_vect_push(struct led_vect* self, struct led* new_led){
+int led_vect_push(struct led_vect* self, const struct led* new_led){
 	
-	struct led* copy = (struct led*)realloc(self->leds,sizeof(struct led*)*(self->size + 1));
-	if(!copy) return;
-	copy[self->size++]= *new_led;
-	self->leds= copy;
-	return;
+	uint8_t* mask = led_vect_mask(self, new_led);
+	if(self->size >= self->capacity || !mask || (*mask & (1 << new_led->pin))) return 1;
+	*mask |= (1 << new_led->pin);
+	self->leds[self->size++] = *new_led;
+	return 0;
 }
 
 /********************************************************************************
 * led_vect_pop: Tar bort eventuellt sista led-objekt i angiven vektor genom
-*               att minska dess storlek med ett. Vid misslyckad omallokering
+*               att minska dess storlek med ett. Lysdioden slcks, s att den
+*               inte lmnas tnd av ett pgende mnster (se led_pattern.h),
+*               och pinnen tas bort ur bitmasken, vilket fungerar eftersom
+*               varje pin bara kan finnas en gng. Om vektorn r tom
 *               returneras felkod 1, annars 0.
 *
 *               - self: Pekare till vektorn vars sista element ska tas bort.
 ********************************************************************************/
-void led_vect_pop(struct led_vect* self){
-	if(self->size <= 1){
-		led_vect_clear(self);
-		return;
-	}
-	struct led* copy = (struct led*)realloc(self->leds,sizeof(struct led*)*(self->size - 1));
-	if(!copy) return;
-	self->leds= copy;
-	return;
+int led_vect_pop(struct led_vect* self){
+	if(!self->size) return 1;
+	struct led* last = &self->leds[--self->size];
+	led_off(last);
+	*led_vect_mask(self, last) &= ~(1 << last->pin);
+	return 0;
 }
 
 /********************************************************************************
-* led_vect_clear:Tmmer och nollstller angiven vektor.
+* led_vect_clear:Tmmer angiven vektor och slcker dess lysdioder. Lagringen
+*                och kapaciteten behlls.
 *
 *                - self: Pekare till vektorn som ska tmmas.
 ********************************************************************************/
 void led_vect_clear(struct led_vect* self){
-	free(self->leds);
+	led_vect_off(self);
 	self->size = 0;
-	self->leds = 0;
+	self->mask_b = 0;
+	self->mask_d = 0;
+	return;
 }
 
 /********************************************************************************
-* led_vect_on: Tnder samtliga lysdioder lagrade i angiven vektor.
+* led_vect_on: Tnder samtliga lysdioder lagrade i angiven vektor samtidigt
+*              med en skrivning per I/O-port. Avbrott inaktiveras under
+*              skrivningen, s att en avbrottsrutin som ndrar samma port
+*              inte skrivs ver.
 *
 *              - self: Pekare till vektorn vars lysdioder ska tndas.
 ********************************************************************************/
 void led_vect_on(struct led_vect* self){
 	
-	for(int i = 0 ; i < self->size ; i++){
-		led_on(&self->leds[i]);	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		PORTB |= self->mask_b;
+		PORTD |= self->mask_d;
 	}
 	return;
 }
 
 
 /********************************************************************************
-* led_vect_off: slcker samtliga lysdioder lagrade i angiven vektor.
+* led_vect_off: slcker samtliga lysdioder lagrade i angiven vektor samtidigt
+*              med en skrivning per I/O-port, se led_vect_on.
 *
 *              - self: Pekare till vektorn vars lysdioder ska slckas.
 ********************************************************************************/
 void led_vect_off(struct led_vect* self){
 	
-	for(uint8_t i = 0 ; i < self->size ; i++){
-		led_off(&self->leds[i]);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		PORTB &= ~self->mask_b;
+		PORTD &= ~self->mask_d;
 	}
 	return;
 }
@@ -119,26 +138,28 @@ void led_vect_blink_sequentally(struct led_vect* self, uint16_t time_delay){
 }
 
 /********************************************************************************
-* led_vect_blink_collectively: Genomfr kollektiv (synkroniserad) blinkning
-*                              av samtliga lysdioder lagrade i angiven vektor.
+* led_vect_toggle: Togglar samtliga lysdioder lagrade i angiven vektor
+*                  samtidigt. En etta som skrivs till PINx togglar motsvarande
+*                  bit i PORTx, s varje port togglas med en enda skrivning
+*                  utan lsning, vilket r skert ven vid avbrott.
 *
-*                              - self          : Pekare till vektorn vars
-*                                                lysdioder ska blinkas.
-*                              - time_delay: Lysdiodernas blinkhastighet
-*                                            mtt i millisekunder.
+*                  - self: Pekare till vektorn vars lysdioder ska togglas.
 ********************************************************************************/
 void led_vect_toggle(struct led_vect* self){
 	
-	for (uint8_t i = 0; i < self->size; i++){
-		led_toggle(&self->leds[i]);
-	}
+	PINB = self->mask_b;
+	PIND = self->mask_d;
 	return;
 }
 
 /********************************************************************************
-* led_vect_toggle: Togglar samtliga lysdioder lagrade i angiven vektor.
+* led_vect_blink_collectively: Genomfr kollektiv (synkroniserad) blinkning
+*                              av samtliga lysdioder lagrade i angiven vektor.
 *
-*                  - self: Pekare till vektorn vars lysdioder ska togglas.
+*                              - self          : Pekare till vektorn vars
+*                                                lysdioder ska blinkas.
+*                              - time_delay: Lysdiodernas blinkhastighet
+*                                            mtt i millisekunder.
 ********************************************************************************/
 void led_vect_blink_collectively(struct led_vect* self, uint16_t time_delay){
 	
@@ -147,3 +168,16 @@ void led_vect_blink_collectively(struct led_vect* self, uint16_t time_delay){
 	return;
 }
 
+/********************************************************************************
+* led_vect_mask: Returnerar pekare till bitmasken fr lysdiodens I/O-port,
+*                eller 0 om porten saknar std (se led_init).
+*
+*                - self: Pekare till vektorn.
+*                - led : Pekare till lysdioden.
+********************************************************************************/
+static inline uint8_t* led_vect_mask(struct led_vect* self, const struct led* led){
+	
+	if (led->io_port_led == IO_PORTB) return &self->mask_b;
+	else if (led->io_port_led == IO_PORTD) return &self->mask_d;
+	else return 0;
+}
@@ -6,10 +6,22 @@
  */ 
 
 /********************************************************************************
-* led_vect.h: Innehller funktionalitet fr implementering av dynamiska
-*               vektorer fr lagring och styrning ver multipla lysdioder eller
-*               andra utportar, realiserat via strukten led_vect samt
+* led_vect.h: Innehller funktionalitet fr implementering av vektorer med
+*               fast kapacitet fr lagring och styrning ver multipla lysdioder
+*               eller andra utportar, realiserat via strukten led_vect samt
 *               associerade funktioner.
+*
+*               Vektorns minne allokeras statiskt nr den deklareras, oftast
+*               via makrot LED_VECT_DEFINE. Ingen dynamisk minnesallokering
+*               sker, s heapen fragmenteras inte och push/pop tar konstant
+*               tid. Kapaciteten kan inte verskridas.
+*
+*               Vektorn hller en bitmask per I/O-port med lagrade lysdioder,
+*               som uppdateras vid push och pop. Samtliga lysdioder tnds,
+*               slcks eller togglas drmed samtidigt med en skrivning per
+*               port, vilket ven kan gras frn en avbrottsrutin. Lagrade
+*               kopior av led-objekten uppdateras inte, s deras enabled
+*               anger inte lysdiodernas lge efter sdana anrop.
 ********************************************************************************/
 
 #ifndef LED_VECT_H_
@@ -22,58 +34,80 @@
 #include "main_header.h"
 
 /********************************************************************************
-* led_vect: Dynamisk vektor fr lagring och styrning av led-objekt, vilket
-*             kan utgras av lysdioder eller andra digitala utportar.
+* led_vect: Vektor med fast kapacitet fr lagring och styrning av led-objekt,
+*             vilket kan utgras av lysdioder eller andra digitala utportar.
 ********************************************************************************/
 
 struct led_vect {
-	struct led* leds;	/* Pekare till array innehllande led-objekt. */
-	size_t size;		/* Vektorns storlek, dvs. antalet befintliga led-objekt. */
+	struct led* leds;	/* Pekare till statisk array innehllande led-objekt. */
+	uint8_t size;		/* Vektorns storlek, dvs. antalet befintliga led-objekt. */
+	uint8_t capacity;	/* Max antal led-objekt, dvs. arrayens storlek. */
+	uint8_t mask_b;		/* Bitmask fr lysdioder p I/O-port B. */
+	uint8_t mask_d;		/* Bitmask fr lysdioder p I/O-port D. */
 };
 
+/********************************************************************************
+* LED_VECT_DEFINE: Deklarerar en vektor med angivet namn och kapacitet samt
+*                  en statisk array fr dess led-objekt. Vektorn r tom och
+*                  behver inte initieras via led_vect_init, exempelvis:
+*
+*                  LED_VECT_DEFINE(leds, 4);
+*                  led_vect_push(&leds, &led1);
+*
+*                  - name    : Vektorns namn.
+*                  - capacity: Max antal led-objekt, 1 - 255.
+********************************************************************************/
+#define LED_VECT_DEFINE(name, capacity) \
+	static struct led name##_storage[(capacity)]; \
+	static struct led_vect name = { name##_storage, 0, (capacity), 0, 0 }
+
 
 /********************************************************************************
-* led_vect_init: Initierar angiven vektor till tom vid start.
+* led_vect_init: Initierar angiven vektor till tom vid start med angiven
+*                array som lagring.
 *
-*                - self: Pekare till vektorn som ska initieras.
+*                - self    : Pekare till vektorn som ska initieras.
+*                - leds    : Pekare till array som led-objekten lagras i.
+*                - capacity: Arrayens storlek, dvs. max antal led-objekt.
 ********************************************************************************/
-void led_vect_init(struct led_vect* self);
+void led_vect_init(struct led_vect* self, struct led* leds, uint8_t capacity);
 
 /********************************************************************************
-* led_vect_push: Lgger till ett nytt led-objekt lngst bak i angiven vektor.
-*                Vid misslyckad minnesallokering returneras felkod 1.
-*                Annars om push-operationen lyckas returneras 0.
+* led_vect_push: Lgger till en kopia av ett led-objekt lngst bak i angiven
+*                vektor. Om vektorn r full eller redan innehller en
+*                lysdiod p samma pin returneras felkod 1, annars 0.
 *
-*                - self*   : Pekare till vektorn som ska tilldelas.
-*                - led_ptr*: Det nya led-objekt som ska lggas till.
+*                - self   : Pekare till vektorn som ska tilldelas.
+*                - new_led: Pekare till led-objektet som ska lggas till.
 ********************************************************************************/
-void led_vect_push(struct led_vect* self, struct led* led_ptr);
+int led_vect_push(struct led_vect* self, const struct led* new_led);
 
 /********************************************************************************
 * led_vect_pop: Tar bort eventuellt sista led-objekt i angiven vektor genom
-*               att minska dess storlek med ett. Vid misslyckad omallokering
-*               returneras felkod 1, annars 0.
+*               att minska dess storlek med ett. Lysdioden slcks. Om vektorn
+*               r tom returneras felkod 1, annars 0.
 *
 *               - self: Pekare till vektorn vars sista element ska tas bort.
 ********************************************************************************/
-void led_vect_pop(struct led_vect* self);
+int led_vect_pop(struct led_vect* self);
 
 /********************************************************************************
-* led_vect_clear:Tmmer och nollstller angiven vektor.
+* led_vect_clear:Tmmer angiven vektor och slcker dess lysdioder. Lagringen
+*                och kapaciteten behlls.
 *
 *                - self: Pekare till vektorn som ska tmmas.
 ********************************************************************************/
 void led_vect_clear(struct led_vect* self);
 
 /********************************************************************************
-* led_vect_on: Tnder samtliga lysdioder lagrade i angiven vektor.
+* led_vect_on: Tnder samtliga lysdioder lagrade i angiven vektor samtidigt.
 *
 *              - self: Pekare till vektorn vars lysdioder ska tndas.
 ********************************************************************************/
 void led_vect_on(struct led_vect* self);
 
 /********************************************************************************
-* led_vect_off: slcker samtliga lysdioder lagrade i angiven vektor.
+* led_vect_off: slcker samtliga lysdioder lagrade i angiven vektor samtidigt.
 *
 *              - self: Pekare till vektorn vars lysdioder ska slckas.
 ********************************************************************************/
@@ -83,6 +117,8 @@ void led_vect_off(struct led_vect* self);
 * led_vect_blink_sequentially: Genomfr sekventiell blinkning av samtliga
 *                              lysdioder lagrade i angiven vektor. Drmed
 *                              blinkar lysdioderna i en sekvens en efter en.
+*                              Blockerar under hela sekvensen, se
+*                              led_pattern.h fr icke-blockerande mnster.
 *
 *                                - self      : Pekare till vektorn vars
 *                                              lysdioder ska blinkas.
@@ -94,6 +130,8 @@ void led_vect_blink_sequentally(struct led_vect* self, uint16_t time_delay);
 /********************************************************************************
 * led_vect_blink_collectively: Genomfr kollektiv (synkroniserad) blinkning
 *                              av samtliga lysdioder lagrade i angiven vektor.
+*                              Blockerar i time_delay ms, se led_pattern.h
+*                              fr icke-blockerande mnster.
 *
 *                              - self          : Pekare till vektorn vars
 *                                                lysdioder ska blinkas.
@@ -103,7 +141,8 @@ void led_vect_blink_sequentally(struct led_vect* self, uint16_t time_delay);
 void led_vect_blink_collectively(struct led_vect* self, uint16_t time_delay);
 
 /********************************************************************************
-* led_vect_toggle: Togglar samtliga lysdioder lagrade i angiven vektor.
+* led_vect_toggle: Togglar samtliga lysdioder lagrade i angiven vektor
+*                  samtidigt genom skrivning till PINx.
 *
 *                  - self: Pekare till vektorn vars lysdioder ska togglas.
 ********************************************************************************/
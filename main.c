@@ -26,6 +26,16 @@
 *		   medelvrdet melan de 5 senaste knapptryckningarna sparas och anvnds som
 *		   frekvens fr utskrift av medeltemperaturen.
 *		   
+*		   main-loopen tar om hand hndelser frn avbrottsrutinerna via
+*		   event_dispatch, se event.h. Systemtickar, knapptryckningar,
+*		   AD-omvandlingar samt kommandon via seriell verfring (se
+*		   command.h) behandlas drmed utanfr avbrottsrutinerna.
+*		   
+*		   nr inget arbete terstr frstts CPU:n i vilolge fram till
+*		   nsta mjukvarutimer lper ut (tickless idle), se sw_timer_idle.
+*		   om TEMP_POWER_DOWN r definierad anvnds i stllet power_sleep,
+*		   som vid lnga perioder anvnder vilolget Power-down.
+*		   
 *		   
 **********************************************************************/
 
@@ -36,7 +46,13 @@ int main(void)
     while (1) 
 	
     {
-		
+		event_dispatch();
+		if (temp_poll()) continue;
+#ifdef TEMP_POWER_DOWN
+		power_sleep(sw_timer_ticks_to_next());
+#else
+		sw_timer_idle();
+#endif
     }
 }
 
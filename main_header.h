@@ -16,11 +16,22 @@
 **********************************************************************/
 
 #include "misc.h"
+#include "event.h"
 #include "button.h"
+#include "debounce.h"
+#include "button_gesture.h"
+#include "port_debounce.h"
+#include "led_pattern.h"
 #include "adc.h"
+#include "adc_scan.h"
+#include "pwm.h"
 #include "setup.h"
 #include "timer.h"
+#include "sw_timer.h"
+#include "power.h"
 #include "temp_sensor.h"
 #include "serial.h"
+#include "telemetry.h"
+#include "command.h"
 
 #endif /* INCFILE1_H_ */
\ No newline at end of file
@@ -17,6 +17,8 @@
 /* Inkluderingsdirektiv: */
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 #include <stdbool.h>
 #include <stdint.h>
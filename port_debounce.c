@@ -0,0 +1,99 @@
+/*
+ * port_debounce.c
+ */ 
+
+/********************************************************************************
+* port_debounce.c: Innehller funktionsdefinitioner fr avstudsning av
+*                  samtliga tryckknappar p en I/O-port samtidigt.
+********************************************************************************/
+#include "port_debounce.h"
+#include <stddef.h>
+
+/* Statiska funktioner: */
+static void port_debounce_on_timer(struct sw_timer* timer);
+static uint8_t port_debounce_read(const enum io_port port);
+
+/********************************************************************************
+* port_debounce_init: Initierar avstudsning av angivna pinnar p en I/O-port
+*                     och startar den periodiska avlsningen. Efter att
+*                     pull-up-resistorerna har aktiverats vntar vi 1 us
+*                     innan startlget lses av, s att synkroniseringen av
+*                     PINx hinner ikapp och pinnarna hinner laddas upp.
+*                     Annars kan ett gammalt lge lsas av, vilket ger en
+*                     falsk nedtryckning eller ett falskt slpp.
+*
+*                     - self    : Pekare till avstudsningen som ska initieras.
+*                     - port    : I/O-porten vars pinnar ska avstudsas.
+*                     - mask    : Pinnar som ska avstudsas.
+*                     - callback: Funktion som anropas vid ndrat lge.
+********************************************************************************/
+void port_debounce_init(struct port_debounce* self, 
+                        const enum io_port port, 
+                        const uint8_t mask, 
+                        void (*callback)(struct port_debounce* self, 
+                                         const uint8_t pressed, 
+                                         const uint8_t released))
+{
+   if (port == IO_PORTB)
+   {
+      DDRB &= ~mask;
+      PORTB |= mask;
+   }
+   else if (port == IO_PORTC)
+   {
+      DDRC &= ~mask;
+      PORTC |= mask;
+   }
+   else if (port == IO_PORTD)
+   {
+      DDRD &= ~mask;
+      PORTD |= mask;
+   }
+
+   _delay_us(1);
+
+   self->port = port;
+   self->mask = mask;
+   self->state = port_debounce_read(port) & mask;
+   self->count0 = 0xFF;
+   self->count1 = 0xFF;
+   self->callback = callback;
+
+   sw_timer_init(&self->timer, port_debounce_on_timer);
+   sw_timer_start_ms(&self->timer, PORT_DEBOUNCE_SAMPLE_MS, PORT_DEBOUNCE_SAMPLE_MS);
+   return;
+}
+
+/********************************************************************************
+* port_debounce_on_timer: Anropas var PORT_DEBOUNCE_SAMPLE_MS ms. Porten
+*                         lses av en gng och samtliga pinnar avstudsas via
+*                         port_debounce_update. Om minst en pin vxlade lge
+*                         anropas callbacken med masker fr nedtryckta
+*                         respektive slppta pinnar.
+*
+*                         - timer: Pekare till timern i avstudsningen.
+********************************************************************************/
+static void port_debounce_on_timer(struct sw_timer* timer)
+{
+   struct port_debounce* self = (struct port_debounce*)((uint8_t*)timer - offsetof(struct port_debounce, timer));
+   const uint8_t changed = port_debounce_update(self, port_debounce_read(self->port));
+
+   if (changed && self->callback)
+   {
+      self->callback(self, changed & self->state, changed & ~self->state);
+   }
+   return;
+}
+
+/********************************************************************************
+* port_debounce_read: Returnerar avlsning av angiven I/O-port.
+*
+*                     - port: I/O-porten som ska lsas av.
+********************************************************************************/
+static uint8_t port_debounce_read(const enum io_port port)
+{
+   if (port == IO_PORTB) return PINB;
+   else if (port == IO_PORTC) return PINC;
+   else if (port == IO_PORTD) return PIND;
+   else return 0;
+}
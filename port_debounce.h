@@ -0,0 +1,121 @@
+/*
+ * port_debounce.h
+ */ 
+
+/********************************************************************************
+* port_debounce.h: Innehller funktionalitet fr avstudsning av samtliga
+*                  tryckknappar p en I/O-port samtidigt via strukten
+*                  port_debounce.
+*
+*                  Porten lses av en gng var PORT_DEBOUNCE_SAMPLE_MS ms via
+*                  en periodisk mjukvarutimer. Varje bit har en tvbitars
+*                  rknare, dr rknarnas lga och hga bitar lagras i var
+*                  sin byte (vertikala rknare). Alla tta bitar avstudsas
+*                  drmed med ett ftal bitoperationer, oavsett hur mnga
+*                  knappar som sitter p porten:
+*
+*                  1. Bitar som skiljer sig frn avstudsat lge rknas ned,
+*                     vriga bitar fr rknaren terstlld.
+*
+*                  2. Nr en rknare slr runt efter fyra avlsningar i fljd
+*                     med samma nya lge vxlar bitens avstudsade lge.
+*
+*                  Avstudsningstiden blir drmed 3 - 4 avlsningsperioder.
+*                  Precis som fr button motsvarar en hg pin nedtryckt knapp.
+*
+*                  Den periodiska timern gr att CPU:n vcks varje
+*                  avlsningsperiod och frhindrar drmed Power-down (se
+*                  power.h). Fr enstaka knappar som ska kunna vcka CPU:n
+*                  anvnds i stllet debounce.h.
+********************************************************************************/
+#ifndef PORT_DEBOUNCE_H_
+#define PORT_DEBOUNCE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "sw_timer.h"
+
+#ifndef PORT_DEBOUNCE_SAMPLE_MS
+#define PORT_DEBOUNCE_SAMPLE_MS 5 /* Tid mellan avlsningar av porten, mtt i ms. */
+#endif
+
+/********************************************************************************
+* port_debounce: Strukt fr avstudsning av tryckknappar p en I/O-port.
+********************************************************************************/
+struct port_debounce
+{
+   enum io_port port; /* I/O-porten som avstudsas. */
+   uint8_t mask;      /* Pinnar p porten som avstudsas. */
+   uint8_t state;     /* Avstudsat lge, en bit per pin. */
+   uint8_t count0;    /* Lg bit i varje pins rknare. */
+   uint8_t count1;    /* Hg bit i varje pins rknare. */
+   struct sw_timer timer; /* Periodisk timer fr avlsning av porten. */
+   void (*callback)(struct port_debounce* self, 
+                    const uint8_t pressed, 
+                    const uint8_t released); /* Anropas vid ndrat lge. */
+};
+
+/********************************************************************************
+* port_debounce_init: Initierar avstudsning av angivna pinnar p en I/O-port.
+*                     Pinnarna stts till inportar med intern pull-up-resistor
+*                     och deras aktuella lge blir startlge, varefter porten
+*                     lses av var PORT_DEBOUNCE_SAMPLE_MS ms.
+*
+*                     - self    : Pekare till avstudsningen som ska initieras.
+*                     - port    : I/O-porten vars pinnar ska avstudsas.
+*                     - mask    : Pinnar som ska avstudsas, exempelvis 0x3C
+*                                 fr pin 2 - 5 p porten.
+*                     - callback: Funktion som anropas frn main-loopen med
+*                                 masker fr nedtryckta respektive slppta
+*                                 pinnar nr minst en pin har ndrat lge.
+********************************************************************************/
+void port_debounce_init(struct port_debounce* self, 
+                        const enum io_port port, 
+                        const uint8_t mask, 
+                        void (*callback)(struct port_debounce* self, 
+                                         const uint8_t pressed, 
+                                         const uint8_t released));
+
+/********************************************************************************
+* port_debounce_update: Uppdaterar de vertikala rknarna med en ny avlsning
+*                       av porten och returnerar en mask med de pinnar vars
+*                       avstudsade lge vxlade. Anropas av timern, men kan
+*                       ven anropas frn en avbrottsrutin med egen avlsning.
+*
+*                       - self  : Pekare till avstudsningen.
+*                       - sample: Ny avlsning av porten (PINx).
+********************************************************************************/
+static inline uint8_t port_debounce_update(struct port_debounce* self, 
+                                           const uint8_t sample)
+{
+   uint8_t changed = (self->state ^ sample) & self->mask;
+   self->count0 = ~(self->count0 & changed);
+   self->count1 = self->count0 ^ (self->count1 & changed);
+   changed &= self->count0 & self->count1;
+   self->state ^= changed;
+   return changed;
+}
+
+/********************************************************************************
+* port_debounce_state: Returnerar avstudsat lge fr samtliga pinnar som
+*                      avstudsas, dr en etta motsvarar nedtryckt knapp.
+*
+*                      - self: Pekare till avstudsningen.
+********************************************************************************/
+static inline uint8_t port_debounce_state(const struct port_debounce* self)
+{
+   return self->state & self->mask;
+}
+
+/********************************************************************************
+* port_debounce_stop: Stoppar avlsningen av porten. Avstudsat lge behlls.
+*
+*                     - self: Pekare till avstudsningen.
+********************************************************************************/
+static inline void port_debounce_stop(struct port_debounce* self)
+{
+   sw_timer_stop(&self->timer);
+   return;
+}
+
+#endif /* PORT_DEBOUNCE_H_ */
@@ -0,0 +1,200 @@
+/*
+ * power.c
+ */ 
+
+/********************************************************************************
+* power.c: Innehller funktionsdefinitioner fr strmsparande vilolge.
+********************************************************************************/
+#include "power.h"
+#include "adc.h"
+#include "serial.h"
+#include "sw_timer.h"
+#include <avr/wdt.h>
+
+/* Statiska variabler: */
+static volatile bool power_wdt_fired = false; /* Indikerar att watchdog-timern vckte CPU:n. */
+static uint64_t power_awake_until = 0;        /* Tidpunkt i systemtickar sedan start innan vilken Power-down inte anvnds. */
+static uint32_t power_sleep_ms = 0;           /* Total tid i Power-down mtt i ms. */
+static uint32_t power_wakeup_count = 0;       /* Antal uppvaknanden ur Power-down. */
+
+/* Statiska funktioner: */
+static void power_down(uint32_t time_ms);
+static void power_wdt_start(const uint8_t index);
+static void power_wdt_stop(void);
+
+/********************************************************************************
+* power_init: Stnger av TWI, SPI, Timer 0 och Timer 2 via PRR samt den
+*             analoga komparatorn via biten ACD i ACSR.
+********************************************************************************/
+void power_init(void)
+{
+   ACSR |= (1 << ACD);
+   PRR |= (1 << PRTWI) | (1 << PRSPI) | (1 << PRTIM0) | (1 << PRTIM2);
+   return;
+}
+
+/********************************************************************************
+* power_sleep: Vljer vilolge utifrn tiden till nsta deadline. Aktiv PWM
+*              indikeras av att motsvarande timer r pslagen i PRR, och
+*              PWM-utgngen skulle stanna i Power-down. Tiden fr
+*              power_keep_awake jmfrs med 64-bitars drifttid, eftersom
+*              en jmfrelse med timer_is_after slutar fungera nr
+*              tidpunkten r mer n 2^31 tickar (ca 24.8 dygn) gammal.
+*
+*              - max_ticks: Antal systemtickar till nsta deadline.
+********************************************************************************/
+void power_sleep(const uint32_t max_ticks)
+{
+   if (max_ticks < TIMER_MS_TO_TICKS(POWER_DOWN_MIN_MS) ||
+       power_awake_until > timer_uptime_ticks() ||
+       !serial_tx_idle() || adc_busy() ||
+       !(PRR & (1 << PRTIM0)) || !(PRR & (1 << PRTIM2)))
+   {
+      timer_idle(max_ticks);
+   }
+   else
+   {
+      power_down(timer_get_time_elapsed_ms(max_ticks));
+   }
+   return;
+}
+
+/********************************************************************************
+* power_keep_awake: Frhindrar Power-down under angiven tid rknat frn nu.
+*                   En tidigare lngre tid frkortas inte. Anropas frn
+*                   main-loopen, eftersom tidpunkten r 64 bitar.
+*
+*                   - time_ms: Tid som CPU:n ska hllas vaken mtt i ms.
+********************************************************************************/
+void power_keep_awake(const uint32_t time_ms)
+{
+   const uint64_t until = timer_uptime_ticks() + timer_get_max_count(time_ms);
+   if (until > power_awake_until) power_awake_until = until;
+   return;
+}
+
+/********************************************************************************
+* power_get_sleep_ms: Returnerar total tid i Power-down sedan start.
+********************************************************************************/
+uint32_t power_get_sleep_ms(void)
+{
+   return power_sleep_ms;
+}
+
+/********************************************************************************
+* power_get_wakeups: Returnerar antalet uppvaknanden ur Power-down.
+********************************************************************************/
+uint32_t power_get_wakeups(void)
+{
+   return power_wakeup_count;
+}
+
+/********************************************************************************
+* power_down: Frstter CPU:n i Power-down i upp till angiven tid.
+*
+*             1. AD-omvandlaren stngs av via biten ADEN, eftersom den annars
+*                drar strm i vilolget. Den sls p igen vid nsta
+*                omvandling.
+*
+*             2. Vi vljer lngsta period fr watchdog-timern som ryms inom
+*                terstende tid. Med avbrott inaktiverade kontrolleras att
+*                inga hndelser och inget avbrott fr systemticken vntar,
+*                varefter watchdog-timern startas och CPU:n frstts i
+*                Power-down med BOD avstngd. Avbrott aktiveras direkt fre
+*                instruktionen sleep.
+*
+*             3. Efter uppvaknande stoppas watchdog-timern. Om den vckte
+*                CPU:n rknas perioden in i systemticken och hoppas fram fr
+*                mjukvarutimrarna. Eftersom time_ms inte strcker sig frbi
+*                nsta deadline lper ingen mjukvarutimer ut under perioden,
+*                s hoppet kostar lika lite oavsett periodens lngd. Vi
+*                fortstter s lnge tid terstr och inga hndelser
+*                vntar. Om ett annat avbrott vckte CPU:n avbryts
+*                vilolget direkt.
+*
+*             - time_ms: Tid till nsta deadline mtt i ms.
+********************************************************************************/
+static void power_down(uint32_t time_ms)
+{
+   ADCSRA &= ~(1 << ADEN);
+
+   while (time_ms >= POWER_WDT_MIN_MS)
+   {
+      uint8_t index = POWER_WDT_MAX_INDEX;
+      while (((uint32_t)POWER_WDT_MIN_MS << index) > time_ms) index--;
+
+      cli();
+
+      if (event_pending() || (TIFR1 & (1 << OCF1A)))
+      {
+         sei();
+         return;
+      }
+
+      power_wdt_fired = false;
+      power_wdt_start(index);
+      set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+      sleep_enable();
+      sleep_bod_disable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+      power_wdt_stop();
+      power_wakeup_count++;
+
+      if (!power_wdt_fired) return;
+
+      const uint32_t period_ms = (uint32_t)POWER_WDT_MIN_MS << index;
+      power_sleep_ms += period_ms;
+      time_ms -= period_ms;
+      const uint32_t ticks = timer_get_max_count(period_ms);
+      timer_add_ticks(ticks);
+      sw_timer_advance(ticks);
+      if (event_pending()) return;
+   }
+   return;
+}
+
+/********************************************************************************
+* power_wdt_start: Startar watchdog-timern i avbrottslge (utan terstllning)
+*                  med angiven period. Perioden vljs via bitarna WDP3 - WDP0,
+*                  dr index 0 - 9 ger 16 ms * 2^index. ndringen krver att
+*                  WDCE och WDE ettstlls, varefter nytt vrde skrivs inom
+*                  fyra klockcykler. Anropas med avbrott inaktiverade.
+*
+*                  - index: Index fr perioden, 0 - POWER_WDT_MAX_INDEX.
+********************************************************************************/
+static void power_wdt_start(const uint8_t index)
+{
+   const uint8_t prescaler = (index & 0x07) | ((index & 0x08) ? (1 << WDP3) : 0);
+   wdt_reset();
+   MCUSR &= ~(1 << WDRF);
+   WDTCSR = (1 << WDCE) | (1 << WDE);
+   WDTCSR = (1 << WDIE) | prescaler;
+   return;
+}
+
+/********************************************************************************
+* power_wdt_stop: Stoppar watchdog-timern.
+********************************************************************************/
+static void power_wdt_stop(void)
+{
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      wdt_reset();
+      MCUSR &= ~(1 << WDRF);
+      WDTCSR = (1 << WDCE) | (1 << WDE);
+      WDTCSR = 0x00;
+   }
+   return;
+}
+
+/********************************************************************************
+* ISR (WDT_vect): Avbrottsrutin som ger rum nr watchdog-timerns period har
+*                 lpt ut och indikerar att CPU:n vcktes av watchdog-timern.
+********************************************************************************/
+ISR (WDT_vect)
+{
+   power_wdt_fired = true;
+   return;
+}
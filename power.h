@@ -0,0 +1,88 @@
+/*
+ * power.h
+ */ 
+
+/********************************************************************************
+* power.h: Innehller funktionalitet fr strmsparande vilolge (Power-down)
+*          fr batteridrivna mtnoder med lnga mtperioder.
+*
+*          Vid initiering stngs oanvnda kretsar av via registret PRR (TWI,
+*          SPI samt Timer 0 och Timer 2, som sls p igen av pwm_init) och
+*          den analoga komparatorn stngs av.
+*
+*          Nr nsta deadline ligger minst POWER_DOWN_MIN_MS fram frstter
+*          power_sleep CPU:n i vilolget Power-down, dr samtliga klockor
+*          stannar, inklusive Timer 1 och USART. CPU:n vcks i stllet av
+*          watchdog-timerns avbrott med lngsta mjliga period (16 ms - 8 s)
+*          som ryms inom terstende tid, varefter tiden rknas in i
+*          systemticken via timer_add_ticks och sw_timer_advance, som bda
+*          hoppar fram hela perioden p en gng i stllet fr att g igenom
+*          varje tick. AD-omvandlaren och BOD stngs av
+*          under vilolget. Tryckknappen kan vcka CPU:n via PCI-avbrott.
+*
+*          USART:ens mottagare saknar klocka i Power-down och kan inte vcka
+*          CPU:n, s tecken som tas emot medan CPU:n sover gr frlorade.
+*          Seriella kommandon tas drfr endast emot medan CPU:n redan r
+*          vaken av annan anledning, exempelvis efter en knapptryckning (se
+*          power_keep_awake). Ett mottaget tecken hller sedan CPU:n vaken
+*          i COMMAND_AWAKE_MS, men kan inte sjlvt avsluta vilolget.
+*
+*          Watchdog-timerns oscillator har en noggrannhet p ca 10 %, och om
+*          CPU:n vcks av ett annat avbrott n watchdog-timern rknas inte
+*          pbrjad period in. Tidtagning som krver noggrannhet ska drfr
+*          ske med CPU:n vaken, se power_keep_awake.
+********************************************************************************/
+#ifndef POWER_H_
+#define POWER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "timer.h"
+
+#ifndef POWER_DOWN_MIN_MS
+#define POWER_DOWN_MIN_MS 100 /* Minsta tid till nsta deadline fr Power-down, mtt i ms. */
+#endif
+
+#define POWER_WDT_MIN_MS 16   /* Kortaste period fr watchdog-timern mtt i ms. */
+#define POWER_WDT_MAX_INDEX 9 /* Index fr lngsta period, 16 ms * 2^9 = 8192 ms. */
+
+/********************************************************************************
+* power_init: Stnger av oanvnda kretsar via PRR samt den analoga
+*             komparatorn. Ska anropas innan eventuell PWM initieras.
+********************************************************************************/
+void power_init(void);
+
+/********************************************************************************
+* power_sleep: Frstter CPU:n i vilolge fram till nsta deadline. Vilolget
+*              Power-down anvnds om nsta deadline ligger minst
+*              POWER_DOWN_MIN_MS fram, CPU:n inte hlls vaken via
+*              power_keep_awake, all seriell data har skickats, ingen
+*              AD-omvandling pgr och ingen PWM-timer r aktiv. Annars
+*              anvnds vilolget Idle via timer_idle.
+*
+*              - max_ticks: Antal systemtickar till nsta deadline.
+********************************************************************************/
+void power_sleep(const uint32_t max_ticks);
+
+/********************************************************************************
+* power_keep_awake: Frhindrar Power-down under angiven tid, exempelvis nr
+*                   tiden mellan knapptryckningar mts eller kommandon tas
+*                   emot. Vilolget Idle anvnds fortfarande.
+*
+*                   - time_ms: Tid som CPU:n ska hllas vaken mtt i ms.
+********************************************************************************/
+void power_keep_awake(const uint32_t time_ms);
+
+/********************************************************************************
+* power_get_sleep_ms: Returnerar total tid i Power-down sedan start mtt i ms.
+*                     Tillsammans med timer_get_ticks ger detta andelen tid
+*                     som CPU:n har varit vaken.
+********************************************************************************/
+uint32_t power_get_sleep_ms(void);
+
+/********************************************************************************
+* power_get_wakeups: Returnerar antalet uppvaknanden ur Power-down sedan start.
+********************************************************************************/
+uint32_t power_get_wakeups(void);
+
+#endif /* POWER_H_ */
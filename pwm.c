@@ -0,0 +1,85 @@
+/*
+ * pwm.c
+ */ 
+
+/********************************************************************************
+* pwm.c: Innehller funktionsdefinitioner fr hrdvarugenererad PWM via
+*        strukten pwm.
+********************************************************************************/
+#include "pwm.h"
+
+/* Makrodefinitioner: */
+#define PWM_TIMER0_PRESCALER ((1 << CS02) | (1 << CS01) | (1 << CS00)) /* Bitar fr val av prescaler, Timer 0. */
+#define PWM_TIMER2_PRESCALER ((1 << CS22) | (1 << CS21) | (1 << CS20)) /* Bitar fr val av prescaler, Timer 2. */
+
+/********************************************************************************
+* pwm_init: Initierar PWM p angiven utgng.
+*
+*           1. Vi sparar adresserna till utgngens jmfrelse- och kontroll-
+*              register samt biten fr anslutning av utgngen.
+*
+*           2. Vi stter utgngens pin till utport och timerkretsen i Fast PWM
+*              Mode via bitarna WGMn1 och WGMn0 i TCCRnA. Om ingen prescaler
+*              r vald startas timerkretsen med prescaler 8 via biten CSn1.
+*              Timerkretsen sls frst p i PRR, eftersom power_init stnger
+*              av oanvnda timerkretsar.
+*
+*           3. Jmfrelsevrdet stts till 0, vilket kopplar bort utgngen.
+*
+*           - self  : Pekare till PWM-utgngen som ska initieras.
+*           - output: Val av utgng.
+********************************************************************************/
+void pwm_init(struct pwm* self, 
+              const enum pwm_output output)
+{
+   if (output == PWM_OC0A || output == PWM_OC0B)
+   {
+      PRR &= ~(1 << PRTIM0);
+      self->tccra = &TCCR0A;
+      self->ocr = output == PWM_OC0A ? &OCR0A : &OCR0B;
+      self->com_bit = output == PWM_OC0A ? COM0A1 : COM0B1;
+      DDRD |= (1 << (output == PWM_OC0A ? PORTD6 : PORTD5));
+      TCCR0A |= (1 << WGM01) | (1 << WGM00);
+      if ((TCCR0B & PWM_TIMER0_PRESCALER) == 0) TCCR0B |= (1 << CS01);
+   }
+   else
+   {
+      PRR &= ~(1 << PRTIM2);
+      self->tccra = &TCCR2A;
+      self->ocr = output == PWM_OC2A ? &OCR2A : &OCR2B;
+      self->com_bit = output == PWM_OC2A ? COM2A1 : COM2B1;
+      if (output == PWM_OC2A) DDRB |= (1 << PORTB3);
+      else DDRD |= (1 << PORTD3);
+      TCCR2A |= (1 << WGM21) | (1 << WGM20);
+      if ((TCCR2B & PWM_TIMER2_PRESCALER) == 0) TCCR2B |= (1 << CS21);
+   }
+
+   pwm_set_duty(self, 0);
+   return;
+}
+
+/********************************************************************************
+* pwm_set_duty: Stter nytt jmfrelsevrde. I Fast PWM Mode ger vrdet 0 en
+*               puls p en klockcykel per period, s utgngen kopplas i stllet
+*               bort via biten COMnx1, varvid pinnen blir lg. Annars ansluts
+*               utgngen, s att den blir hg frn periodens brjan tills
+*               rknaren nr jmfrelsevrdet. Kontrollregistret uppdateras
+*               med avbrott inaktiverade, eftersom Timer 0 och Timer 2 delar
+*               det mellan tv utgngar.
+*
+*               - self: Pekare till PWM-utgngen.
+*               - duty: Nytt jmfrelsevrde.
+********************************************************************************/
+void pwm_set_duty(struct pwm* self, 
+                  const uint8_t duty)
+{
+   self->duty = duty;
+   *(self->ocr) = duty;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      if (duty) *(self->tccra) |= (1 << self->com_bit);
+      else *(self->tccra) &= ~(1 << self->com_bit);
+   }
+   return;
+}
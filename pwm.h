@@ -0,0 +1,107 @@
+/*
+ * pwm.h
+ */ 
+
+/********************************************************************************
+* pwm.h: Innehller funktionalitet fr hrdvarugenererad PWM via strukten pwm.
+*        Till skillnad frn adc_delay_on och adc_delay_off, dr CPU:n vntar
+*        under hela perioden, genereras signalen av timerkretsen medan CPU:n
+*        r ledig. Pulsbredden bestms av ett jmfrelsevrde (OCRnx) mellan
+*        0 och 255 och kan uppdateras automatiskt frn en analog pin varje
+*        gng en AD-omvandling r klar, se adc_set_pwm.
+*
+*        Timer 0 och Timer 2 anvnds i Fast PWM Mode med toppvrde 255,
+*        medan Timer 1 anvnds fr systemticken (se timer.h). Med prescaler 8
+*        blir PWM-frekvensen 16 MHz / (8 * 256) = 7812.5 Hz, exakt och
+*        oberoende av programmets exekvering. Fljande utgngar stds:
+*
+*        Utgng     Pin p ATmega328P   Pin p Arduino Uno
+*        PWM_OC0A         PORTD6               6
+*        PWM_OC0B         PORTD5               5
+*        PWM_OC2A         PORTB3               11
+*        PWM_OC2B         PORTD3               3
+********************************************************************************/
+
+#ifndef PWM_H_
+#define PWM_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+#define PWM_MAX_DUTY 255 /* Jmfrelsevrde som motsvarar 100 % duty cycle. */
+
+/********************************************************************************
+* pwm_output: Enumeration fr val av PWM-utgng.
+********************************************************************************/
+enum pwm_output
+{
+   PWM_OC0A, /* Timer 0, utgng A (pin 6). */
+   PWM_OC0B, /* Timer 0, utgng B (pin 5). */
+   PWM_OC2A, /* Timer 2, utgng A (pin 11). */
+   PWM_OC2B  /* Timer 2, utgng B (pin 3). */
+};
+
+/********************************************************************************
+* pwm: Strukt fr implementering av hrdvarugenererad PWM p en av timer-
+*      kretsarnas utgngar.
+********************************************************************************/
+struct pwm
+{
+   volatile uint8_t* ocr;   /* Pekare till jmfrelseregistret OCRnx. */
+   volatile uint8_t* tccra; /* Pekare till kontrollregistret TCCRnA. */
+   uint8_t com_bit;         /* Bit COMnx1 fr anslutning av utgngen. */
+   uint8_t duty;            /* Aktuellt jmfrelsevrde, 0 - PWM_MAX_DUTY. */
+};
+
+/********************************************************************************
+* pwm_init: Initierar PWM p angiven utgng med duty cycle 0 %. Utgngens pin
+*           stts till utport och timerkretsen stts i Fast PWM Mode. Om
+*           timerkretsen inte har startats startas den med prescaler 8.
+*
+*           - self  : Pekare till PWM-utgngen som ska initieras.
+*           - output: Val av utgng.
+********************************************************************************/
+void pwm_init(struct pwm* self, 
+              const enum pwm_output output);
+
+/********************************************************************************
+* pwm_set_duty: Stter nytt jmfrelsevrde mellan 0 (0 %) och PWM_MAX_DUTY
+*               (100 %). Vid 0 kopplas utgngen bort frn timerkretsen, s att
+*               signalen blir helt lg i stllet fr en kort puls per period.
+*               Funktionen kan anropas frn en avbrottsrutin.
+*
+*               - self: Pekare till PWM-utgngen.
+*               - duty: Nytt jmfrelsevrde.
+********************************************************************************/
+void pwm_set_duty(struct pwm* self, 
+                  const uint8_t duty);
+
+/********************************************************************************
+* pwm_set_from_adc: Stter jmfrelsevrde utifrn ett AD-omvandlat vrde.
+*                   Eftersom maxvrdet r 1023 * 2^n (se adc_max_value)
+*                   erhlls jmfrelsevrdet 0 - 255 genom att skifta vrdet
+*                   2 + n steg t hger, utan division.
+*
+*                   - self          : Pekare till PWM-utgngen.
+*                   - value         : AD-omvandlat vrde.
+*                   - oversample_bits: Antal extra bitar via versampling (n).
+********************************************************************************/
+static inline void pwm_set_from_adc(struct pwm* self, 
+                                    const uint16_t value, 
+                                    const uint8_t oversample_bits)
+{
+   pwm_set_duty(self, (uint8_t)(value >> (2 + oversample_bits)));
+   return;
+}
+
+/********************************************************************************
+* pwm_get_duty: Returnerar aktuellt jmfrelsevrde.
+*
+*               - self: Pekare till PWM-utgngen.
+********************************************************************************/
+static inline uint8_t pwm_get_duty(const struct pwm* self)
+{
+   return self->duty;
+}
+
+#endif /* PWM_H_ */
@@ -4,73 +4,168 @@
 ********************************************************************************/
 #include "serial.h"
 
+/* Makrodefinitioner: */
+#define SERIAL_TX_MASK (SERIAL_TX_BUFFER_SIZE - 1) /* Mask fr indexering av sndbufferten. */
+#define SERIAL_RX_MASK (SERIAL_RX_BUFFER_SIZE - 1) /* Mask fr indexering av mottagningsbufferten. */
+#define SERIAL_DIGITS_BUFFER_SIZE 12               /* 10 siffror, decimalpunkt samt nolltecken. */
+
+/* Statiska variabler: */
+static volatile char serial_tx_buffer[SERIAL_TX_BUFFER_SIZE]; /* Ringbuffert med tecken som ska skickas. */
+static volatile uint8_t serial_tx_head = 0;                   /* Index dr nsta tecken lggs in. */
+static volatile uint8_t serial_tx_tail = 0;                   /* Index fr nsta tecken som ska skickas. */
+static volatile uint16_t serial_tx_dropped_count = 0;         /* Antal tecken slngda vid full buffert. */
+static volatile char serial_rx_buffer[SERIAL_RX_BUFFER_SIZE]; /* Ringbuffert med mottagna tecken. */
+static volatile uint8_t serial_rx_head = 0;                   /* Index dr nsta mottagna tecken lggs in. */
+static volatile uint8_t serial_rx_tail = 0;                   /* Index fr nsta tecken som ska lsas. */
+static volatile uint16_t serial_rx_dropped_count = 0;         /* Antal mottagna tecken slngda vid full buffert. */
+static int16_t serial_baud_error_value = 0;                   /* Avvikelse frn nskad baud rate i tiondels procent. */
+
+/* Statiska funktioner: */
+static bool serial_tx_put(const char c);
+static void serial_tx_send_next(void);
+static void serial_print_digits(uint32_t number, const uint8_t decimals);
+static inline uint32_t serial_divu10(const uint32_t number, uint8_t* remainder);
+
 /********************************************************************************
-* serial_init: Initierar seriell transmission, dr vi skickar en bit i taget
-*              med angiven baud rate (bithastighet) mtt i kilobits per sekund
-*              (kbps). Ett vagnreturstecken \r skickas s att frsta utskriften
-*              hamnar lngst till vnster.
+* serial_init_usart: Initierar seriell transmission, dr vi skickar en bit i
+*                    taget med angiven baud rate (bithastighet) mtt i bitar
+*                    per sekund. Ett vagnreturstecken \r skickas s att frsta
+*                    utskriften hamnar lngst till vnster. Om avvikelsen frn
+*                    nskad baud rate r strre n SERIAL_BAUD_MAX_ERROR
+*                    returneras false, annars true.
 *
-*              1. Vi aktiverar seriell transmission (sndning) genom att
-*                 ettstlla biten TXEN0 (Transmitter Enable 0) i kontroll- och
-*                 statusregistret UCSR0B (USART Control and Status Register 0 B).
+*                    1. Vi aktiverar seriell transmission (sndning) genom att
+*                       ettstlla biten TXEN0 (Transmitter Enable 0) i kontroll-
+*                       och statusregistret UCSR0B (USART Control and Status
+*                       Register 0 B). Vi aktiverar ven mottagning via biten
+*                       RXEN0 (Receiver Enable 0) samt avbrott vid mottaget
+*                       tecken via biten RXCIE0 (RX Complete Interrupt Enable 0).
 *
-*              2. Vi stller in att tta bitar ska skickas i taget (ett tecken
-*                 r tta bitar) via ettstllning av bitar UCSZ00 - UCSZ01
-*                 (USART Character Size 00 - 01) i kontroll- och status-
-*                 registret UCSR0C (USART Control and Status Register 0 C).
+*                    2. Vi stller in att tta bitar ska skickas i taget (ett
+*                       tecken r tta bitar) via ettstllning av bitar UCSZ00 -
+*                       UCSZ01 (USART Character Size 00 - 01) i kontroll- och
+*                       statusregistret UCSR0C (USART Control and Status
+*                       Register 0 C).
 *
-*              3. Vi stller in baud rate (verfringshastighet) genom att
-*                 skriva till det 16-bitars registret UBRR0 (USART Baud Rate
-*                 Register 0), tilldelat enligt formeln:
+*                    3. Vi stller in baud rate (verfringshastighet) genom att
+*                       skriva till det 16-bitars registret UBRR0 (USART Baud
+*                       Rate Register 0), tilldelat enligt formeln:
 *
-*                 UBRR0 = F_CPU / (16 * baud_rate_kbps) - 1,
+*                       UBRR0 = F_CPU / (div * baud_rate) - 1,
 *
-*                 dr F_CPU r mikrodatorns klockfrekvens och baud_rate_kbps
-*                 r verfringshastigheten i kilobits per sekund. Vi anvnder
-*                 flyttalsdivision genom att stta 16 till 16.0. Vi avrundar
-*                 till nrmaste heltal genom att addera 0.5. Vi typomvandlar
-*                 resultatet till uint16_t, d UBRR0 r 16 bitar bred.
+*                       dr div r 16 vid normal hastighet och 8 vid dubbel
+*                       hastighet. Berkningen sker med heltal avrundat till
+*                       nrmaste heltal via makrot SERIAL_UBRR. Vi berknar
+*                       avvikelsen fr bda lgena och vljer det lge som ger
+*                       minst avvikelse. Vid lika avvikelse vljs normal
+*                       hastighet, d mottagaren d samplar varje bit fler
+*                       gnger. Vid dubbel hastighet ettstlls biten U2X0
+*                       (Double Transmission Speed 0) i UCSR0A.
 *
-*              4. Vi lgger ett vagnreturstecken 'r' i dataregistret UDR0
-*                 (USART Data Register 0, vrt postfack) s att frsta
-*                 utskriften hamnar lngst till vnster.
+*                    4. Vi lgger ett vagnreturstecken 'r' i dataregistret UDR0
+*                       (USART Data Register 0, vrt postfack) s att frsta
+*                       utskriften hamnar lngst till vnster.
 *
-*              5. Vi indikerar att seriell verfring r aktiverat, s att
-*                 vi inte kan terinitiera USART av misstag.
+*                    5. Vi indikerar att seriell verfring r aktiverat, s att
+*                       vi inte kan terinitiera USART av misstag.
+*
+*                    - baud_rate: nskad baud rate mtt i bitar per sekund.
 ********************************************************************************/
-void serial_init(const uint16_t baud_rate_kbps)
+bool serial_init_usart(const uint32_t baud_rate)
 {
 	static bool serial_initialized = false;
-	if (serial_initialized) return;
+	if (serial_initialized) return SERIAL_BAUD_ABS(serial_baud_error_value) <= SERIAL_BAUD_MAX_ERROR;
+	if (baud_rate == 0 || baud_rate > SERIAL_BAUD_MAX) return false;
+
+	const uint32_t ubrr_normal = SERIAL_UBRR(baud_rate, 16UL);
+	const uint32_t ubrr_double = SERIAL_UBRR(baud_rate, 8UL);
+	const int16_t error_normal = ubrr_normal <= 4095 ? SERIAL_BAUD_ERROR(baud_rate, 16UL) : INT16_MAX;
+	const int16_t error_double = ubrr_double <= 4095 ? SERIAL_BAUD_ERROR(baud_rate, 8UL) : INT16_MAX;
 
-	UCSR0B = (1 << TXEN0);
+	UCSR0B = (1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0);
 	UCSR0C = (1 << UCSZ00) | (1 << UCSZ01);
-	UBRR0 = (uint16_t)(F_CPU / (16.0 * baud_rate_kbps) - 1 + 0.5);
+
+	if (SERIAL_BAUD_ABS(error_double) < SERIAL_BAUD_ABS(error_normal))
+	{
+		UCSR0A |= (1 << U2X0);
+		UBRR0 = (uint16_t)ubrr_double;
+		serial_baud_error_value = error_double;
+	}
+	else
+	{
+		UCSR0A &= ~(1 << U2X0);
+		UBRR0 = (uint16_t)ubrr_normal;
+		serial_baud_error_value = error_normal;
+	}
+
 	UDR0 = '\r';
+	UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);
 
 	serial_initialized = true;
-	return;
+	return SERIAL_BAUD_ABS(serial_baud_error_value) <= SERIAL_BAUD_MAX_ERROR;
+}
+
+/********************************************************************************
+* serial_baud_error: Returnerar avvikelsen mellan verklig och nskad baud rate
+*                    mtt i tiondels procent, exempelvis 21 fr 2.1 %.
+********************************************************************************/
+int16_t serial_baud_error(void)
+{
+	return serial_baud_error_value;
 }
 
 /********************************************************************************
 * serial_print_char: Skickar angivet tecken till ansluten seriell terminal.
 *
-*                    1. Vi vntar p att postfacket UDR0 (USART Data Register 0)
-*                       blir tomt, vilket indikeras via biten UDRE0 (USART
-*                       Data Register Empty 0) i i kontroll- och status-
-*                       registret UCSR0A (USART Control and Status Register 0 A),
-*                       som d blir ettstlld. S lnge UDRE0 r noll s vntar
-*                       vi via en loop.
+*                    1. Vi frsker lgga tecknet i sndbufferten, varefter
+*                       avbrottsrutinen USART_UDRE_vect skickar det s fort
+*                       postfacket UDR0 (USART Data Register 0) r tomt.
+*
+*                    2. Om sndbufferten r full sker vald tgrd enligt
+*                       SERIAL_TX_OVERFLOW_POLICY:
+*
+*                       - SERIAL_TX_DROP_NEWEST: Tecknet slngs och rknaren
+*                         fr slngda tecken rknas upp.
 *
-*                   2. S fort postfacket UDR0 r tomt s lgger vi i det nya
-*                      tecknet s att det skickas sedan.
+*                       - SERIAL_TX_DROP_OLDEST: ldsta tecknet i bufferten
+*                         slngs och rknaren rknas upp, varefter vi frsker
+*                         igen.
+*
+*                       - SERIAL_TX_BLOCK: Vi vntar tills plats finns. Om
+*                         avbrott r inaktiverade (exempelvis vid anrop frn
+*                         en avbrottsrutin) kan USART_UDRE_vect inte exekvera,
+*                         s d vntar vi i stllet p att biten UDRE0 i
+*                         UCSR0A ettstlls och skickar nsta tecken sjlva.
 *
 *                    - c: Tecknet som ska skickas.
 ********************************************************************************/
 void serial_print_char(const char c)
 {
-	while ((UCSR0A & (1 << UDRE0)) == 0);
-	UDR0 = c;
+	while (!serial_tx_put(c))
+	{
+#if SERIAL_TX_OVERFLOW_POLICY == SERIAL_TX_DROP_NEWEST
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			serial_tx_dropped_count++;
+		}
+		return;
+#elif SERIAL_TX_OVERFLOW_POLICY == SERIAL_TX_DROP_OLDEST
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			if (((serial_tx_head + 1) & SERIAL_TX_MASK) == serial_tx_tail)
+			{
+				serial_tx_tail = (serial_tx_tail + 1) & SERIAL_TX_MASK;
+				serial_tx_dropped_count++;
+			}
+		}
+#else
+		if ((SREG & (1 << SREG_I)) == 0)
+		{
+			while ((UCSR0A & (1 << UDRE0)) == 0);
+			serial_tx_send_next();
+		}
+#endif
+	}
 	return;
 }
 
@@ -103,102 +198,316 @@ void serial_print_string(const char* s)
 
 /********************************************************************************
 * serial_print_integer: Skriver angivet signerat heltal till ansluten seriell
-*                       terminal. I praktiken omvandlas heltalet till text
-*                       via funktionen sprintf frn stdio.h och skickas.
-*
-*                       1. Deklarerar och initierar en tom strng som rymmer
-*                          20 tecken. I denna strng ska heltalet lggas,
-*                          fast omvandlat till text.
-*
-*                       2. Vi omvandlar heltalet till text och lagrar i
-*                          strngen via anrop av funktionen sprintf. Eftersom
-*                          talet r 32-bitar lngt anvnds formatspecificerare
-*                          %ld (long decimal).
-*
-*                       3. Vi skickar talet som text via strngen s.
+*                       terminal. Talet skrivs som ett fixtal utan decimaler
+*                       via funktionen serial_print_fixed.
 *
 *                       - number: Talet som ska skrivas.
 ********************************************************************************/
 void serial_print_integer(const int32_t number)
 {
-	char s[20] = { '\0' };
-	sprintf(s, "%ld", number);
-	serial_print_string(s);
+	serial_print_fixed(number, 0);
 	return;
 }
 
 /********************************************************************************
 * serial_print_unsigned: Skriver angivet osignerat heltal till ansluten seriell
-*                        terminal. I praktiken omvandlas heltalet till text
-*                        via funktionen sprintf frn stdio.h och skickas.
-*
-*                        1. Deklarerar och initierar en tom strng som rymmer
-*                           20 tecken. I denna strng ska heltalet lggas,
-*                           fast omvandlat till text.
-*
-*                        2. Vi omvandlar heltalet till text och lagrar i
-*                           strngen via anrop av funktionen sprintf. Eftersom
-*                           talet r 32-bitar lngt anvnds formatspecificerare
-*                           %lu (long unsigned).
-*
-*                        3. Vi skickar talet som text via strngen s.
+*                        terminal. Talet omvandlas till text via den statiska
+*                        funktionen serial_print_digits, utan sprintf.
 *
 *                        - number: Talet som ska skrivas.
 ********************************************************************************/
 void serial_print_unsigned(const uint32_t number)
 {
-	char s[20] = { '\0' };
-	sprintf(s, "%lu", number);
-	serial_print_string(s);
+	serial_print_digits(number, 0);
 	return;
 }
 
 /********************************************************************************
-* serial_print_double: Skriver angivet flyttal till ansluten seriell terminal.
+* serial_print_unsigned64: Skriver angivet osignerat 64-bitars heltal till
+*                          ansluten seriell terminal. Tal som ryms i 32 bitar
+*                          skrivs via serial_print_digits, medan strre tal
+*                          omvandlas siffra fr siffra med 64-bitars division,
+*                          som r betydligt lngsammare.
 *
-*                      1. Vi deklarerar och initierar en tom strng som rymmer
-*                         20 tecken.
+*                          - number: Talet som ska skrivas.
+********************************************************************************/
+void serial_print_unsigned64(const uint64_t number)
+{
+	if (number <= UINT32_MAX)
+	{
+		serial_print_digits((uint32_t)number, 0);
+		return;
+	}
+
+	char s[21];
+	uint8_t i = sizeof(s) - 1;
+	uint64_t remaining = number;
+	s[i] = '\0';
+
+	do
+	{
+		s[--i] = '0' + (uint8_t)(remaining % 10);
+		remaining /= 10;
+	} while (remaining);
+
+	serial_print_string(&s[i]);
+	return;
+}
+
+/********************************************************************************
+* serial_print_fixed: Skriver angivet fixtal till ansluten seriell terminal.
+*                     Talet anges som ett heltal skalat med 10^decimals,
+*                     exempelvis skrivs 2105 med tv decimaler som 21.05
+*                     och -5 med tv decimaler som -0.05.
 *
-*                      2. Vi erhller heltalsdelen av talet via typomvandling
-*                         till uint32_t och lagrar i en konstant dpt integer.
+*                     1. Om talet r negativt skriver vi ett minustecken och
+*                        omvandlar talet till sitt belopp. Beloppet berknas
+*                        som 0 - number i osignerad aritmetik, s att ven
+*                        INT32_MIN hanteras korrekt.
 *
-*                      3. Om heltalet r ver eller lika med noll, s extraheras
-*                         decimaltalet genom att ta flyttalsdelen - heltalsdelen,
-*                         exempelvis 3.79 - 3 = 0.79. Vi multiplicerar med 100
-*                         fr att f tv decimaler, exempelvis 79, avrundat
-*                         till nrmaste heltal.
+*                     2. Vi skriver beloppet med angivet antal decimaler via
+*                        funktionen serial_print_digits.
 *
-*                      4. Annars om heltalet r negativt extraheras decimaldelen
-*                         genom att subtrahera heltalsdelen med decimaldelen,
-*                         exempelvis -3 - (-3.79) = 0.79. Vi multiplicerar med
-*                         100 fr att f tv decimaler, exempelvis 79, avrundat
-*                         till nrmaste heltal.
+*                     - number  : Talet som ska skrivas, skalat med 10^decimals.
+*                     - decimals: Antal decimaler, max SERIAL_MAX_DECIMALS.
+********************************************************************************/
+void serial_print_fixed(const int32_t number, const uint8_t decimals)
+{
+	if (number < 0)
+	{
+		serial_print_char('-');
+		serial_print_digits(0UL - (uint32_t)number, decimals);
+	}
+	else
+	{
+		serial_print_digits((uint32_t)number, decimals);
+	}
+	return;
+}
+
+/********************************************************************************
+* serial_print_double: Skriver angivet flyttal till ansluten seriell terminal
+*                      med tv decimaler.
 *
-*                      5. Vi stter ihop flyttalen i strngen, typomvandlat
-*                         till text, separerade med en punkt.
+*                      1. Vi omvandlar talet till hundradelar avrundat till
+*                         nrmaste heltal, dr avrundningen sker bort frn
+*                         noll s att ven negativa tal avrundas korrekt.
 *
-*                      6. Vi skriver ut flyttalet genom att anropa funktionen
-*                         serial_print_string med strngen som argument.
+*                      2. Vi skriver talet som ett fixtal med tv decimaler
+*                         via funktionen serial_print_fixed, vilket gr att
+*                         exempelvis 1.05 skrivs som 1.05 och -0.5 som -0.50.
 *
 *                      - number: Talet som ska skrivas.
 ********************************************************************************/
 void serial_print_double(const double number)
 {
-	char s[20] = { '\0' };
-	const int32_t integer = (int32_t)number;
-	int32_t decimal;
+	const int32_t centi = (int32_t)(number * 100 + (number < 0 ? -0.5 : 0.5));
+	serial_print_fixed(centi, 2);
+	return;
+}
 
-	if (integer >= 0)
+/********************************************************************************
+* serial_tx_dropped: Returnerar antalet tecken som har slngts p grund av
+*                    full sndbuffert sedan start. Eftersom rknaren r 16
+*                    bitar lses den av med avbrott inaktiverade.
+********************************************************************************/
+uint16_t serial_tx_dropped(void)
+{
+	uint16_t dropped;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		decimal = (int32_t)((number - integer) * 100 + 0.5);
+		dropped = serial_tx_dropped_count;
 	}
-	else
+	return dropped;
+}
+
+/********************************************************************************
+* serial_tx_idle: Indikerar ifall all data har skickats, dvs. att snd-
+*                 bufferten r tom och att sista tecknet har lmnat sndarens
+*                 skiftregister, vilket indikeras av flaggan TXC0 i UCSR0A.
+********************************************************************************/
+bool serial_tx_idle(void)
+{
+	return serial_tx_head == serial_tx_tail && (UCSR0A & (1 << TXC0));
+}
+
+/********************************************************************************
+* serial_read_char: Hmtar nsta mottagna tecken frn mottagningsbufferten
+*                   utan att vnta. Eftersom endast avbrottsrutinen
+*                   USART_RX_vect skriver till bufferten och endast denna
+*                   funktion lser frn den rcker det att indexen r 8 bitar,
+*                   vilka lses och skrivs atomrt.
+*
+*                   - c: Pekare till variabel dr det mottagna tecknet lagras.
+********************************************************************************/
+bool serial_read_char(char* c)
+{
+	const uint8_t tail = serial_rx_tail;
+	if (tail == serial_rx_head) return false;
+	*c = serial_rx_buffer[tail];
+	serial_rx_tail = (tail + 1) & SERIAL_RX_MASK;
+	return true;
+}
+
+/********************************************************************************
+* serial_rx_dropped: Returnerar antalet mottagna tecken som har slngts p
+*                    grund av full mottagningsbuffert sedan start.
+********************************************************************************/
+uint16_t serial_rx_dropped(void)
+{
+	uint16_t dropped;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		dropped = serial_rx_dropped_count;
+	}
+	return dropped;
+}
+
+/********************************************************************************
+* serial_tx_put: Lgger angivet tecken sist i sndbufferten och aktiverar
+*                avbrott nr postfacket UDR0 r tomt, genom ettstllning av
+*                biten UDRIE0 (USART Data Register Empty Interrupt Enable 0)
+*                i UCSR0B. Eftersom utskrift kan ske bde frn main-loopen
+*                och frn avbrottsrutiner sker detta med avbrott inaktiverade.
+*                Om bufferten r full returneras false, annars true.
+*
+*                - c: Tecknet som ska lggas i sndbufferten.
+********************************************************************************/
+static bool serial_tx_put(const char c)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		const uint8_t next = (serial_tx_head + 1) & SERIAL_TX_MASK;
+		if (next == serial_tx_tail) return false;
+		serial_tx_buffer[serial_tx_head] = c;
+		serial_tx_head = next;
+		UCSR0B |= (1 << UDRIE0);
+	}
+	return true;
+}
+
+/********************************************************************************
+* serial_tx_send_next: Lgger nsta tecken i sndbufferten i postfacket UDR0.
+*                      Om bufferten r tom inaktiveras avbrott p UDRE0, s
+*                      att avbrottsrutinen inte exekverar i ondan. Flaggan
+*                      TXC0 (USART Transmit Complete 0) nollstlls genom att
+*                      skriva en etta till den, s att den ettstlls frst nr
+*                      tecknet har skickats, se serial_tx_idle. vriga flaggor
+*                      i UCSR0A skrivs som noll, frutom U2X0 som behlls.
+********************************************************************************/
+static void serial_tx_send_next(void)
+{
+	if (serial_tx_head == serial_tx_tail)
+	{
+		UCSR0B &= ~(1 << UDRIE0);
+		return;
+	}
+	UDR0 = serial_tx_buffer[serial_tx_tail];
+	UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);
+	serial_tx_tail = (serial_tx_tail + 1) & SERIAL_TX_MASK;
+	return;
+}
+
+/********************************************************************************
+* ISR (USART_UDRE_vect): Avbrottsrutin som ger rum nr postfacket UDR0 r
+*                        tomt. Nsta tecken i sndbufferten skickas.
+********************************************************************************/
+ISR (USART_UDRE_vect)
+{
+	serial_tx_send_next();
+	return;
+}
+
+/********************************************************************************
+* ISR (USART_RX_vect): Avbrottsrutin som ger rum nr ett tecken har tagits
+*                      emot. Tecknet lses alltid frn UDR0, s att avbrottet
+*                      kvitteras, och lggs i mottagningsbufferten om plats
+*                      finns. Annars rknas antalet slngda tecken upp. En
+*                      hndelse av typen EVENT_RX skickas fr varje lagrat
+*                      tecken, s att main-loopen kan lsa bufferten.
+********************************************************************************/
+ISR (USART_RX_vect)
+{
+	const char c = UDR0;
+	const uint8_t next = (serial_rx_head + 1) & SERIAL_RX_MASK;
+
+	if (next == serial_rx_tail)
 	{
-		decimal = (int32_t)((integer - number) * 100 + 0.5);
+		serial_rx_dropped_count++;
+		return;
 	}
 
-	sprintf(s, "%ld.%ld", integer, decimal);
-	serial_print_string(s);
+	serial_rx_buffer[serial_rx_head] = c;
+	serial_rx_head = next;
+	event_post(EVENT_RX, (uint8_t)c, 0);
 	return;
 }
 
+/********************************************************************************
+* serial_print_digits: Skriver angivet osignerat tal med angivet antal
+*                      decimaler till ansluten seriell terminal, utan att
+*                      anvnda sprintf.
+*
+*                      1. Vi fyller en strng bakifrn med en siffra i taget,
+*                         dr varje siffra erhlls som resten vid division
+*                         med tio via funktionen serial_divu10.
+*
+*                      2. Nr angivet antal decimaler har skrivits lgger vi
+*                         till en decimalpunkt. Vi fortstter tills talet r
+*                         noll och minst en siffra finns fre decimalpunkten,
+*                         s att inledande nollor i decimalerna behlls.
+*
+*                      - number  : Talet som ska skrivas.
+*                      - decimals: Antal decimaler, max SERIAL_MAX_DECIMALS.
+********************************************************************************/
+static void serial_print_digits(uint32_t number, const uint8_t decimals)
+{
+	char s[SERIAL_DIGITS_BUFFER_SIZE];
+	uint8_t i = sizeof(s) - 1;
+	uint8_t digits = 0;
+	const uint8_t num_decimals = decimals > SERIAL_MAX_DECIMALS ? SERIAL_MAX_DECIMALS : decimals;
+
+	s[i] = '\0';
+
+	do
+	{
+		uint8_t remainder;
+		number = serial_divu10(number, &remainder);
+		s[--i] = '0' + remainder;
+		if (++digits == num_decimals) s[--i] = '.';
+	} while (number || digits <= num_decimals);
+
+	serial_print_string(&s[i]);
+	return;
+}
+
+/********************************************************************************
+* serial_divu10: Dividerar angivet tal med tio och returnerar kvoten, medan
+*                resten lagras p angiven adress. Eftersom ATmega328P saknar
+*                instruktion fr division berknas kvoten med skift och
+*                additioner (number * 0.8 / 8), vilket r betydligt snabbare
+*                n ett anrop till 32-bitars divisionsrutinen. Den skattade
+*                kvoten kan bli ett fr lg, vilket korrigeras via resten.
+*
+*                - number   : Talet som ska divideras.
+*                - remainder: Pekare till variabel dr resten (0 - 9) lagras.
+********************************************************************************/
+static inline uint32_t serial_divu10(const uint32_t number, uint8_t* remainder)
+{
+	uint32_t quotient = (number >> 1) + (number >> 2);
+	quotient += quotient >> 4;
+	quotient += quotient >> 8;
+	quotient += quotient >> 16;
+	quotient >>= 3;
+
+	uint8_t rest = (uint8_t)(number - ((quotient << 2) + quotient) * 2);
+
+	if (rest > 9)
+	{
+		quotient++;
+		rest -= 10;
+	}
+
+	*remainder = rest;
+	return quotient;
+}
@@ -1,21 +1,128 @@
 /********************************************************************************
 * serial.h: Innehller drivrutiner fr seriell verfring med USART.
 *           Vi skickar ett tecken i taget asynkront med en verfringhastighet
-*           p 9600 kbps eller dylikt.
+*           p 9600 kbps eller dylikt. Mottagna tecken buffras och kan lsas
+*           av frn main-loopen.
 ********************************************************************************/
 #ifndef SERIAL_H_
 #define SERIAL_H_
 
 #include "misc.h"
-#include <stdio.h>
+#include "event.h"
+
+/********************************************************************************
+* Sndbuffert: Tecken som skrivs ut lggs i en ringbuffert och skickas sedan
+*              ett i taget frn avbrottsrutinen USART_UDRE_vect, s att
+*              utskrifter inte behver vnta p USART (vilket tar ca 1 ms per
+*              tecken vid 9600 baud). Buffertens storlek samt vad som ska ske
+*              nr bufferten r full kan stllas in vid kompilering.
+********************************************************************************/
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 128 /* Sndbuffertens storlek i byte, mste vara 2^n och max 256. */
+#endif
+
+#define SERIAL_TX_BLOCK       0 /* Vnta tills plats finns i sndbufferten. */
+#define SERIAL_TX_DROP_NEWEST 1 /* Slng det nya tecknet om sndbufferten r full. */
+#define SERIAL_TX_DROP_OLDEST 2 /* Slng ldsta tecknet i sndbufferten om den r full. */
+
+#ifndef SERIAL_TX_OVERFLOW_POLICY
+#define SERIAL_TX_OVERFLOW_POLICY SERIAL_TX_BLOCK /* tgrd vid full sndbuffert. */
+#endif
+
+/********************************************************************************
+* Mottagningsbuffert: Mottagna tecken lggs i en ringbuffert frn avbrotts-
+*                     rutinen USART_RX_vect och lses sedan av frn main-loopen
+*                     via funktionen serial_read_char. Om bufferten r full
+*                     slngs det mottagna tecknet.
+********************************************************************************/
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 32 /* Mottagningsbuffertens storlek i byte, mste vara 2^n och max 256. */
+#endif
+
+#define SERIAL_MAX_DECIMALS 9 /* Maximalt antal decimaler vid utskrift av fixtal. */
+
+#if (SERIAL_TX_BUFFER_SIZE & (SERIAL_TX_BUFFER_SIZE - 1)) || SERIAL_TX_BUFFER_SIZE > 256
+#error "SERIAL_TX_BUFFER_SIZE mste vara 2^n och max 256!"
+#endif
+
+#if (SERIAL_RX_BUFFER_SIZE & (SERIAL_RX_BUFFER_SIZE - 1)) || SERIAL_RX_BUFFER_SIZE > 256
+#error "SERIAL_RX_BUFFER_SIZE mste vara 2^n och max 256!"
+#endif
+
+/********************************************************************************
+* Baud rate: UBRR0 berknas med heltalsaritmetik fr bde normal hastighet
+*            (division med 16) och dubbel hastighet (U2X0, division med 8).
+*            Avvikelsen mellan verklig och nskad baud rate anges i tiondels
+*            procent, exempelvis 21 fr 2.1 %, och trunkeras mot noll. Vid
+*            16 MHz ger exempelvis 9600 baud 0.1 %, 57600 baud -0.7 % (U2X0,
+*            verklig avvikelse -0.79 %) och 115200 baud
+*            2.1 % (U2X0), medan 250000, 500000 och 1000000 baud blir exakta.
+*            115200 baud krver drmed att SERIAL_BAUD_MAX_ERROR hjs.
+********************************************************************************/
+#define SERIAL_BAUD_MAX 1000000UL /* Hgsta baud rate som stds. */
+
+#ifndef SERIAL_BAUD_MAX_ERROR
+#define SERIAL_BAUD_MAX_ERROR 20 /* Strsta tilltna avvikelse i tiondels procent (2 %). */
+#endif
+
+#define SERIAL_UBRR(baud, div) \
+   ((F_CPU + (div) / 2 * (baud)) / ((div) * (baud)) - 1)
+#define SERIAL_BAUD_ERROR(baud, div) \
+   (((int32_t)(F_CPU / ((div) * (SERIAL_UBRR(baud, div) + 1))) - (int32_t)(baud)) * 1000L / (int32_t)(baud))
+#define SERIAL_BAUD_ABS(x) ((x) < 0 ? -(x) : (x))
+#define SERIAL_BAUD_MODE_VALID(baud, div) \
+   (SERIAL_UBRR(baud, div) <= 4095UL && SERIAL_BAUD_ABS(SERIAL_BAUD_ERROR(baud, div)) <= SERIAL_BAUD_MAX_ERROR)
+#define SERIAL_BAUD_RATE_VALID(baud) \
+   ((baud) > 0 && (baud) <= SERIAL_BAUD_MAX && \
+    (SERIAL_BAUD_MODE_VALID(baud, 16UL) || SERIAL_BAUD_MODE_VALID(baud, 8UL)))
+
+/********************************************************************************
+* serial_init_usart: Initierar USART med angiven baud rate. Anropas via
+*                    serial_init, se nedan.
+*
+*                    - baud_rate: nskad baud rate mtt i bitar per sekund.
+********************************************************************************/
+bool serial_init_usart(const uint32_t baud_rate);
+
+/********************************************************************************
+* serial_baud_rate_invalid: Deklareras men definieras aldrig. Anrop som inte
+*                           optimeras bort ger kompileringsfel, se serial_init.
+********************************************************************************/
+extern void serial_baud_rate_invalid(void)
+   __attribute__((error("baud rate saknar std eller avviker mer n SERIAL_BAUD_MAX_ERROR")));
 
 /********************************************************************************
 * serial_init: Initierar seriell transmission, dr vi skickar en bit i taget
-*              med angiven baud rate (bithastighet) mtt i kilobits per sekund
-*              (kbps). Ett vagnreturstecken \r skickas s att frsta utskriften
-*              hamnar lngst till vnster.
+*              med angiven baud rate (bithastighet) mtt i bitar per sekund,
+*              upp till SERIAL_BAUD_MAX. Normal eller dubbel hastighet (U2X0)
+*              vljs beroende p vilken som ger minst avvikelse. Ett vagn-
+*              returstecken \r skickas s att frsta utskriften hamnar
+*              lngst till vnster.
+*
+*              Om baud rate anges som en konstant kontrolleras den vid
+*              kompilering (med optimering aktiverad), s att en baud rate
+*              som avviker mer n SERIAL_BAUD_MAX_ERROR ger kompileringsfel.
+*              Annars returneras false om avvikelsen r fr stor, vilket
+*              ven kan lsas av via serial_baud_error.
+*
+*              - baud_rate: nskad baud rate mtt i bitar per sekund.
 ********************************************************************************/
-void serial_init(const uint16_t baud_rate_kbps);
+static inline __attribute__((always_inline)) bool serial_init(const uint32_t baud_rate)
+{
+#ifdef __OPTIMIZE__
+   if (__builtin_constant_p(baud_rate) && !SERIAL_BAUD_RATE_VALID(baud_rate))
+   {
+      serial_baud_rate_invalid();
+   }
+#endif
+   return serial_init_usart(baud_rate);
+}
+
+/********************************************************************************
+* serial_baud_error: Returnerar avvikelsen mellan verklig och nskad baud rate
+*                    mtt i tiondels procent, exempelvis 21 fr 2.1 %.
+********************************************************************************/
+int16_t serial_baud_error(void);
 
 /********************************************************************************
 * serial_print_char: Skickar angivet tecken till ansluten seriell terminal.
@@ -48,12 +155,59 @@ void serial_print_integer(const int32_t number);
 void serial_print_unsigned(const uint32_t number);
 
 /********************************************************************************
-* serial_print_double: Skriver angivet flyttal till ansluten seriell terminal.
+* serial_print_unsigned64: Skriver angivet osignerat 64-bitars heltal till
+*                          ansluten seriell terminal, exempelvis drifttid.
+*
+*                          - number: Talet som ska skrivas.
+********************************************************************************/
+void serial_print_unsigned64(const uint64_t number);
+
+/********************************************************************************
+* serial_print_fixed: Skriver angivet fixtal till ansluten seriell terminal.
+*                     Talet anges som ett heltal skalat med 10^decimals,
+*                     exempelvis skrivs 2105 med tv decimaler som 21.05.
+*
+*                     - number  : Talet som ska skrivas, skalat med 10^decimals.
+*                     - decimals: Antal decimaler, max SERIAL_MAX_DECIMALS.
+********************************************************************************/
+void serial_print_fixed(const int32_t number, const uint8_t decimals);
+
+/********************************************************************************
+* serial_print_double: Skriver angivet flyttal till ansluten seriell terminal
+*                      med tv decimaler.
 *
 *                      - number: Talet som ska skrivas.
 ********************************************************************************/
 void serial_print_double(const double number);
 
+/********************************************************************************
+* serial_tx_dropped: Returnerar antalet tecken som har slngts p grund av
+*                    full sndbuffert sedan start. Rknaren anvnds endast
+*                    med SERIAL_TX_DROP_NEWEST samt SERIAL_TX_DROP_OLDEST.
+********************************************************************************/
+uint16_t serial_tx_dropped(void);
+
+/********************************************************************************
+* serial_tx_idle: Indikerar ifall all data har skickats, dvs. att snd-
+*                 bufferten r tom och att sista tecknet har skickats ut.
+********************************************************************************/
+bool serial_tx_idle(void);
+
+/********************************************************************************
+* serial_read_char: Hmtar nsta mottagna tecken frn mottagningsbufferten
+*                   utan att vnta. Om ett tecken fanns returneras true,
+*                   annars false.
+*
+*                   - c: Pekare till variabel dr det mottagna tecknet lagras.
+********************************************************************************/
+bool serial_read_char(char* c);
+
+/********************************************************************************
+* serial_rx_dropped: Returnerar antalet mottagna tecken som har slngts p
+*                    grund av full mottagningsbuffert sedan start.
+********************************************************************************/
+uint16_t serial_rx_dropped(void);
+
 /********************************************************************************
 * serial_print_new_line: Ser till att nsta utskrift hamnar p nsta rad.
 ********************************************************************************/
@@ -14,6 +14,8 @@
 #include "timer.h"
 #include "serial.h"
 #include "temp_sensor.h"
+#include "command.h"
+#include "power.h"
 
 /********************************************************************************
 * setup: initeierar det inbyggda systemet
@@ -24,16 +26,12 @@
 
 void setup(void)
 {
+	power_init();
 	button_init(&b1,13);
 	adc_init(&pin2,2);
 	
-	timer_init(&timer1_button,TIMER_NR_0,60000);
-	timer_init(&timer2_temp_read,TIMER_NR_2,60000);
-	
-	timer_enable_interrupt(&timer1_button);
-	timer_enable_interrupt(&timer2_temp_read);
-	
 	serial_init(9600);
+	command_init();
 	
 	temp_init();
 	
@@ -17,7 +17,6 @@
 
 struct button b1;
 struct adc_pin pin2;
-struct timer timer1_button,timer2_temp_read;
 
 #ifndef SETUP_H_
 #define SETUP_H_
@@ -0,0 +1,233 @@
+/*
+ * sw_timer.c
+ */ 
+
+/********************************************************************************
+* sw_timer.c: Innehller funktionsdefinitioner fr mjukvarutimrar via strukten
+*             sw_timer.
+********************************************************************************/
+#include "sw_timer.h"
+
+/* Makrodefinitioner: */
+#define SW_TIMER_MASK (SW_TIMER_WHEEL_SIZE - 1) /* Mask fr index i hjulet. */
+
+/* Statiska variabler: */
+static struct sw_timer* sw_timer_wheel[SW_TIMER_WHEEL_SIZE]; /* Frsta timern i varje fack. */
+static struct timer sw_timer_tick_timer;                    /* Timer som anropar sw_timer_tick. */
+static volatile uint32_t sw_timer_now = 0;                  /* Aktuell tid mtt i systemtickar. */
+static bool sw_timer_initialized = false;                   /* Indikerar ifall hjulet r kopplat till systemticken. */
+
+/* Statiska funktioner: */
+static void sw_timer_tick(struct timer* self);
+static void sw_timer_link(struct sw_timer* self);
+static void sw_timer_unlink(struct sw_timer* self);
+
+/********************************************************************************
+* sw_timer_init: Initierar mjukvarutimer med angiven callback. Vid frsta
+*                anropet initieras en timer som anropar sw_timer_tick vid
+*                varje systemtick.
+*
+*                - self    : Pekare till timern som ska initieras.
+*                - callback: Funktion som ska anropas nr timern lper ut.
+********************************************************************************/
+void sw_timer_init(struct sw_timer* self, 
+                   void (*callback)(struct sw_timer* self))
+{
+   self->expiry = 0;
+   self->period = 0;
+   self->callback = callback;
+   self->next = 0;
+   self->prev = 0;
+   self->active = false;
+
+   if (!sw_timer_initialized)
+   {
+      sw_timer_initialized = true;
+      timer_init(&sw_timer_tick_timer, 0);
+      timer_set_callback(&sw_timer_tick_timer, sw_timer_tick);
+      timer_enable_interrupt(&sw_timer_tick_timer);
+   }
+   return;
+}
+
+/********************************************************************************
+* sw_timer_start: Startar (eller startar om) angiven timer. Eventuell tidigare
+*                 placering i hjulet tas bort, varefter utlsningstiden
+*                 berknas frn aktuell tid och timern lggs frst i
+*                 motsvarande fack. Sker med avbrott inaktiverade.
+*
+*                 - self        : Pekare till timern som ska startas.
+*                 - delay_ticks : Antal systemtickar till frsta utlsning (minst 1).
+*                 - period_ticks: Periodtid mtt i systemtickar, 0 fr one-shot.
+********************************************************************************/
+void sw_timer_start(struct sw_timer* self, 
+                    const uint32_t delay_ticks, 
+                    const uint32_t period_ticks)
+{
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      if (self->active) sw_timer_unlink(self);
+      self->expiry = sw_timer_now + (delay_ticks ? delay_ticks : 1);
+      self->period = period_ticks;
+      sw_timer_link(self);
+   }
+   return;
+}
+
+/********************************************************************************
+* sw_timer_stop: Stoppar angiven timer genom att ta bort den frn hjulet.
+*                Sker med avbrott inaktiverade.
+*
+*                - self: Pekare till timern som ska stoppas.
+********************************************************************************/
+void sw_timer_stop(struct sw_timer* self)
+{
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      if (self->active) sw_timer_unlink(self);
+   }
+   return;
+}
+
+/********************************************************************************
+* sw_timer_ticks_to_next: Returnerar antalet systemtickar tills nsta timer
+*                         lper ut. Samtliga fack gs igenom, eftersom en
+*                         timer i ett fack kan ligga ett eller flera varv
+*                         fram. Tiden rknas frn sw_timer_now, dvs. senast
+*                         behandlade tick, och jmfrs som skillnad med tecken
+*                         s att verslag av 32-bitarstiden hanteras.
+********************************************************************************/
+uint32_t sw_timer_ticks_to_next(void)
+{
+   uint32_t ticks = UINT32_MAX;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      for (uint8_t slot = 0; slot < SW_TIMER_WHEEL_SIZE; ++slot)
+      {
+         for (struct sw_timer* i = sw_timer_wheel[slot]; i; i = i->next)
+         {
+            const int32_t remaining = (int32_t)(i->expiry - sw_timer_now);
+            if (remaining <= 0) return 0;
+            if ((uint32_t)remaining < ticks) ticks = (uint32_t)remaining;
+         }
+      }
+   }
+   return ticks;
+}
+
+/********************************************************************************
+* sw_timer_advance: Flyttar fram aktuell tid med angivet antal tickar.
+*
+*                   1. Tiden flyttas fram direkt till tick fre nsta
+*                      utlsningstid, eller hela vgen om ingen timer lper
+*                      ut inom angivet antal tickar.
+*
+*                   2. Om tickar terstr behandlas nsta tick som vanligt
+*                      via sw_timer_tick, s att timrar som lper ut d
+*                      anropas, varefter vi fortstter frn steg 1.
+*
+*                   Antalet varv beror drmed p antalet timrar som lper
+*                   ut, inte p antalet tickar. Anropas frn main-loopen.
+*
+*                   - ticks: Antal systemtickar som har passerat.
+********************************************************************************/
+void sw_timer_advance(uint32_t ticks)
+{
+   while (ticks)
+   {
+      const uint32_t next = sw_timer_ticks_to_next();
+      const uint32_t skip = next > ticks ? ticks : (next ? next - 1 : 0);
+
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      {
+         sw_timer_now += skip;
+      }
+      ticks -= skip;
+
+      if (ticks)
+      {
+         sw_timer_tick(0);
+         ticks--;
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* sw_timer_tick: Anropas vid varje systemtick och gr igenom facket fr
+*                aktuell tid.
+*
+*                1. Vi rknar upp aktuell tid och vljer motsvarande fack.
+*
+*                2. Vi sker efter en timer i facket vars utlsningstid har
+*                   ntts, tar bort den frn hjulet och anropar dess callback.
+*                   Eftersom callbacken kan starta och stoppa andra timrar i
+*                   samma fack brjar skningen om frn brjan av facket
+*                   efter varje callback.
+*
+*                3. Om timern r periodisk och inte har startats om av
+*                   callbacken lggs den tillbaka i hjulet med utlsningstid
+*                   en period fram, rknat frn fregende utlsningstid s
+*                   att ingen drift uppstr.
+*
+*                - self: Pekare till timern fr systemticken (anvnds ej).
+********************************************************************************/
+static void sw_timer_tick(struct timer* self)
+{
+   const uint32_t now = ++sw_timer_now;
+   struct sw_timer* i = sw_timer_wheel[now & SW_TIMER_MASK];
+
+   while (i)
+   {
+      if (i->expiry != now)
+      {
+         i = i->next;
+         continue;
+      }
+
+      sw_timer_unlink(i);
+      if (i->callback) i->callback(i);
+
+      if (!i->active && i->period)
+      {
+         i->expiry = now + i->period;
+         sw_timer_link(i);
+      }
+      i = sw_timer_wheel[now & SW_TIMER_MASK];
+   }
+   return;
+}
+
+/********************************************************************************
+* sw_timer_link: Lgger angiven timer frst i facket fr dess utlsningstid.
+*
+*                - self: Pekare till timern som ska lggas till.
+********************************************************************************/
+static void sw_timer_link(struct sw_timer* self)
+{
+   struct sw_timer** slot = &sw_timer_wheel[self->expiry & SW_TIMER_MASK];
+   self->prev = 0;
+   self->next = *slot;
+   if (*slot) (*slot)->prev = self;
+   *slot = self;
+   self->active = true;
+   return;
+}
+
+/********************************************************************************
+* sw_timer_unlink: Tar bort angiven timer frn dess fack i konstant tid via
+*                  pekarna till fregende och nsta timer.
+*
+*                  - self: Pekare till timern som ska tas bort.
+********************************************************************************/
+static void sw_timer_unlink(struct sw_timer* self)
+{
+   if (self->prev) self->prev->next = self->next;
+   else sw_timer_wheel[self->expiry & SW_TIMER_MASK] = self->next;
+   if (self->next) self->next->prev = self->prev;
+   self->next = 0;
+   self->prev = 0;
+   self->active = false;
+   return;
+}
@@ -0,0 +1,143 @@
+/*
+ * sw_timer.h
+ */ 
+
+/********************************************************************************
+* sw_timer.h: Innehller funktionalitet fr mjukvarutimrar via strukten
+*             sw_timer. Ett godtyckligt antal mjukvarutimrar delar p
+*             systemticken (se timer.h) och anropar en callback nr de lper
+*             ut, antingen en gng (one-shot) eller periodiskt.
+*
+*             Timrarna lagras i ett hjul (hashed timer wheel) med
+*             SW_TIMER_WHEEL_SIZE fack, dr varje timer placeras i facket
+*             fr sin absoluta utlsningstid modulo hjulets storlek. Varje
+*             fack r en dubbellnkad lista, s att start och stopp av en
+*             timer sker i konstant tid. Vid varje systemtick gs endast ett
+*             fack igenom, dr timrar vars utlsningstid inte har ntts nnu
+*             (dvs. ligger ett eller flera varv fram) hoppas ver.
+*
+*             Callbacks anropas frn main-loopen nr systemticken tas om hand
+*             via event_dispatch och br vara korta, eftersom efterfljande
+*             tickar annars hinner kas upp. En callback fr
+*             starta och stoppa godtyckliga timrar, inklusive sin egen.
+********************************************************************************/
+
+#ifndef SW_TIMER_H_
+#define SW_TIMER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "timer.h"
+
+#ifndef SW_TIMER_WHEEL_SIZE
+#define SW_TIMER_WHEEL_SIZE 16 /* Antal fack i hjulet, mste vara 2^n och max 256. */
+#endif
+
+#if (SW_TIMER_WHEEL_SIZE & (SW_TIMER_WHEEL_SIZE - 1)) || SW_TIMER_WHEEL_SIZE > 256
+#error "SW_TIMER_WHEEL_SIZE mste vara 2^n och max 256!"
+#endif
+
+/********************************************************************************
+* sw_timer: Strukt fr implementering av mjukvarutimrar.
+********************************************************************************/
+struct sw_timer
+{
+   uint32_t expiry;                         /* Absolut tid fr utlsning mtt i systemtickar. */
+   uint32_t period;                         /* Periodtid mtt i systemtickar, 0 vid one-shot. */
+   void (*callback)(struct sw_timer* self); /* Anropas nr timern lper ut. */
+   struct sw_timer* next;                   /* Nsta timer i samma fack. */
+   struct sw_timer* prev;                   /* Fregende timer i samma fack (eller 0). */
+   volatile bool active;                    /* Indikerar ifall timern r startad. */
+};
+
+/********************************************************************************
+* sw_timer_init: Initierar mjukvarutimer med angiven callback. Timern startas
+*                inte frrn sw_timer_start anropas. Vid frsta anropet
+*                kopplas hjulet till systemticken.
+*
+*                - self    : Pekare till timern som ska initieras.
+*                - callback: Funktion som ska anropas nr timern lper ut.
+********************************************************************************/
+void sw_timer_init(struct sw_timer* self, 
+                   void (*callback)(struct sw_timer* self));
+
+/********************************************************************************
+* sw_timer_start: Startar (eller startar om) angiven timer, som lper ut
+*                 efter angivet antal systemtickar och drefter periodiskt
+*                 med angiven periodtid. Periodiska timrar lper ut vid
+*                 fasta tidpunkter, oberoende av hur lng tid callbacken tar.
+*
+*                 - self        : Pekare till timern som ska startas.
+*                 - delay_ticks : Antal systemtickar till frsta utlsning (minst 1).
+*                 - period_ticks: Periodtid mtt i systemtickar, 0 fr one-shot.
+********************************************************************************/
+void sw_timer_start(struct sw_timer* self, 
+                    const uint32_t delay_ticks, 
+                    const uint32_t period_ticks);
+
+/********************************************************************************
+* sw_timer_start_ms: Startar angiven timer med tider mtt i millisekunder,
+*                    se sw_timer_start. Omvandlingen till systemtickar sker
+*                    med heltalsaritmetik och berknas vid kompilering fr
+*                    konstanta argument.
+*
+*                    - self     : Pekare till timern som ska startas.
+*                    - delay_ms : Tid till frsta utlsning mtt i millisekunder.
+*                    - period_ms: Periodtid mtt i millisekunder, 0 fr one-shot.
+********************************************************************************/
+static inline void sw_timer_start_ms(struct sw_timer* self, 
+                                     const uint32_t delay_ms, 
+                                     const uint32_t period_ms)
+{
+   sw_timer_start(self, timer_get_max_count(delay_ms), timer_get_max_count(period_ms));
+   return;
+}
+
+/********************************************************************************
+* sw_timer_stop: Stoppar angiven timer. Om timern inte r startad grs
+*                ingenting.
+*
+*                - self: Pekare till timern som ska stoppas.
+********************************************************************************/
+void sw_timer_stop(struct sw_timer* self);
+
+/********************************************************************************
+* sw_timer_ticks_to_next: Returnerar antalet systemtickar tills nsta startade
+*                         timer lper ut, 0 om en timer redan skulle ha lpt
+*                         ut, eller UINT32_MAX om ingen timer r startad.
+********************************************************************************/
+uint32_t sw_timer_ticks_to_next(void);
+
+/********************************************************************************
+* sw_timer_advance: Flyttar fram tiden fr mjukvarutimrarna med angivet antal
+*                   tickar utan att g igenom hjulet fr varje tick. Timrar
+*                   som lper ut under tiden anropas i tur och ordning.
+*                   Anvnds tillsammans med timer_add_ticks efter vilolget
+*                   Power-down, se power.h.
+*
+*                   - ticks: Antal systemtickar som har passerat.
+********************************************************************************/
+void sw_timer_advance(uint32_t ticks);
+
+/********************************************************************************
+* sw_timer_idle: Frstter CPU:n i vilolge fram till nsta startade timer
+*                lper ut, eller tills ett annat avbrott sker, se timer_idle.
+*                Anropas frn main-loopen nr inget annat arbete terstr.
+********************************************************************************/
+static inline void sw_timer_idle(void)
+{
+   timer_idle(sw_timer_ticks_to_next());
+   return;
+}
+
+/********************************************************************************
+* sw_timer_active: Indikerar ifall angiven timer r startad.
+*
+*                  - self: Pekare till timern som ska kontrolleras.
+********************************************************************************/
+static inline bool sw_timer_active(const struct sw_timer* self)
+{
+   return self->active;
+}
+
+#endif /* SW_TIMER_H_ */
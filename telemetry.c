@@ -0,0 +1,114 @@
+/*
+ * telemetry.c
+ */ 
+
+/********************************************************************************
+* telemetry.c: Innehller funktionsdefinitioner fr att skicka mtvrden som
+*              kompakta binra ramar via USART.
+********************************************************************************/
+#include "telemetry.h"
+#include <util/crc16.h>
+
+/* Statiska variabler: */
+static uint8_t telemetry_sequence = 0; /* Lpnummer fr nsta ram. */
+
+/********************************************************************************
+* telemetry_send: Packar angivna mtvrden i en binr ram med lpnummer och
+*                 CRC-16, COBS-kodar ramen och skickar den via USART.
+*
+*                 1. Vi lgger in flten byte fr byte i little endian, s att
+*                    ramens utseende inte beror p hur kompilatorn lgger ut
+*                    strukten i minnet.
+*
+*                 2. Vi berknar CRC-16 ver flten via _crc_xmodem_update
+*                    frn util/crc16.h med startvrdet 0xFFFF och lgger
+*                    den sist i ramen.
+*
+*                 3. Vi COBS-kodar ramen och skickar den fljt av en nolla,
+*                    som markerar att ramen r slut.
+*
+*                 - frame: Pekare till mtvrdena som ska skickas.
+********************************************************************************/
+void telemetry_send(const struct telemetry_frame* frame)
+{
+	uint8_t data[TELEMETRY_FRAME_SIZE];
+	uint8_t encoded[TELEMETRY_FRAME_SIZE + 1];
+	uint16_t crc = 0xFFFF;
+
+	data[0] = telemetry_sequence++;
+	data[1] = (uint8_t)(frame->timestamp_ms);
+	data[2] = (uint8_t)(frame->timestamp_ms >> 8);
+	data[3] = (uint8_t)(frame->timestamp_ms >> 16);
+	data[4] = (uint8_t)(frame->timestamp_ms >> 24);
+	data[5] = (uint8_t)(frame->adc_raw);
+	data[6] = (uint8_t)(frame->adc_raw >> 8);
+	data[7] = (uint8_t)(frame->temp_centi);
+	data[8] = (uint8_t)((uint16_t)frame->temp_centi >> 8);
+	data[9] = (uint8_t)(frame->period_ms);
+	data[10] = (uint8_t)(frame->period_ms >> 8);
+
+	for (uint8_t i = 0; i < TELEMETRY_PAYLOAD_SIZE; ++i)
+	{
+		crc = _crc_xmodem_update(crc, data[i]);
+	}
+
+	data[TELEMETRY_PAYLOAD_SIZE] = (uint8_t)(crc);
+	data[TELEMETRY_PAYLOAD_SIZE + 1] = (uint8_t)(crc >> 8);
+
+	const uint8_t len = telemetry_cobs_encode(data, TELEMETRY_FRAME_SIZE, encoded);
+
+	for (uint8_t i = 0; i < len; ++i)
+	{
+		serial_print_char((char)encoded[i]);
+	}
+
+	serial_print_char('\0');
+	return;
+}
+
+/********************************************************************************
+* telemetry_cobs_encode: COBS-kodar angiven data och returnerar antalet byte
+*                        i den kodade datan. Varje nolla erstts med avstndet
+*                        till nsta nolla, och en frsta byte anger avstndet
+*                        till den frsta nollan. Drmed innehller den kodade
+*                        datan inga nollor.
+*
+*                        1. Vi reserverar platsen fr frsta avstndsbyten
+*                           och brjar rkna avstndet frn 1.
+*
+*                        2. Fr varje nolla i indatan skriver vi avstndet p
+*                           den reserverade platsen och reserverar en ny plats.
+*                           vriga byte kopieras rakt av.
+*
+*                        3. Slutligen skrivs avstndet fr sista blocket.
+*
+*                        - data  : Pekare till datan som ska kodas.
+*                        - len   : Antal byte som ska kodas, max 253.
+*                        - output: Pekare till buffert som rymmer len + 1 byte.
+********************************************************************************/
+uint8_t telemetry_cobs_encode(const uint8_t* data, 
+                              const uint8_t len, 
+                              uint8_t* output)
+{
+	uint8_t code_index = 0;
+	uint8_t write_index = 1;
+	uint8_t code = 1;
+
+	for (uint8_t i = 0; i < len; ++i)
+	{
+		if (data[i] == 0)
+		{
+			output[code_index] = code;
+			code_index = write_index++;
+			code = 1;
+		}
+		else
+		{
+			output[write_index++] = data[i];
+			code++;
+		}
+	}
+
+	output[code_index] = code;
+	return write_index;
+}
@@ -0,0 +1,73 @@
+/*
+ * telemetry.h
+ */ 
+
+/********************************************************************************
+* telemetry.h: Innehller funktionalitet fr att skicka mtvrden som kompakta
+*              binra ramar i stllet fr text. Varje ram innehller samma
+*              flt i en fast ordning (little endian), fljt av en CRC-16
+*              (CCITT, polynom 0x1021, startvrde 0xFFFF) berknad ver
+*              flten:
+*
+*              Byte   Flt           Typ        Beskrivning
+*               0     sequence       uint8_t    Lpnummer, rknas upp per ram.
+*               1     timestamp_ms   uint32_t   Drifttid vid mtningen i ms (lga 32 bitar).
+*               5     adc_raw        uint16_t   Senaste AD-vrdet (10 - 13 bitar).
+*               7     temp_centi     int16_t    Medeltemperatur i hundradels C.
+*               9     period_ms      uint16_t   Mtperiod i ms (mttad vid 65535).
+*              11     crc            uint16_t   CRC-16 ver byte 0 - 10.
+*
+*              Ramen kodas sedan med COBS (Consistent Overhead Byte Stuffing),
+*              s att den inte innehller ngra nollor, och avslutas med en
+*              nolla. Mottagaren kan drmed alltid synkronisera p nsta nolla.
+*              En ram blir totalt 15 byte jmfrt med ca 50 byte i textformat.
+*
+*              Ramarna avkodas p vrddatorn med tools/telemetry_decode.py.
+********************************************************************************/
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+
+/* Makrodefinitioner: */
+#define TELEMETRY_PAYLOAD_SIZE 11                               /* Antal byte med mtvrden. */
+#define TELEMETRY_FRAME_SIZE (TELEMETRY_PAYLOAD_SIZE + 2)       /* Mtvrden + CRC-16. */
+#define TELEMETRY_ENCODED_SIZE (TELEMETRY_FRAME_SIZE + 2)       /* COBS-kodad ram + avslutande nolla. */
+
+/********************************************************************************
+* telemetry_frame: Strukt som innehller mtvrden som ska skickas i en ram.
+*                  Lpnumret lggs till automatiskt vid sndning.
+********************************************************************************/
+struct telemetry_frame
+{
+	uint32_t timestamp_ms; /* Drifttid vid mtningen mtt i millisekunder, slr runt efter ca 49 dygn. */
+	uint16_t adc_raw;      /* Senaste AD-omvandlade vrdet, se adc_max_value. */
+	int16_t temp_centi;    /* Temperatur mtt i hundradels grader Celsius. */
+	uint16_t period_ms;    /* Mtperiod mtt i millisekunder. */
+};
+
+/********************************************************************************
+* telemetry_send: Packar angivna mtvrden i en binr ram med lpnummer och
+*                 CRC-16, COBS-kodar ramen och skickar den via USART.
+*
+*                 - frame: Pekare till mtvrdena som ska skickas.
+********************************************************************************/
+void telemetry_send(const struct telemetry_frame* frame);
+
+/********************************************************************************
+* telemetry_cobs_encode: COBS-kodar angiven data och returnerar antalet byte
+*                        i den kodade datan, vilket r len + 1 fr len < 254.
+*                        Den avslutande nollan lggs inte till.
+*
+*                        - data  : Pekare till datan som ska kodas.
+*                        - len   : Antal byte som ska kodas, max 253.
+*                        - output: Pekare till buffert som rymmer len + 1 byte.
+********************************************************************************/
+uint8_t telemetry_cobs_encode(const uint8_t* data, 
+                              const uint8_t len, 
+                              uint8_t* output);
+
+#endif /* TELEMETRY_H_ */
@@ -7,56 +7,214 @@
 
 /* inkluderingsdirektiv */
 #include "timer.h"
+#include "sw_timer.h"
 #include "temp_sensor.h"
 #include "misc.h"
 #include "serial.h"
 
 /* deklaration av statiska funtuoner. */
-static inline double temp_calc_avrg_array_value(double data_array[],uint8_t array_size);
-static void temp_get_avrage_temp(double new_temp);
-static void temp_get_avrage_time(uint32_t new_avrage_ms);
-static inline double temp_read_temprature(void);
+static inline int32_t temp_calc_avrg_array_value(const int32_t data_array[],uint8_t array_size);
+static void temp_get_avrage_temp(int16_t new_temp_centi);
+static void temp_get_avrage_time(uint32_t new_interval_us);
+static inline int16_t temp_calc_temprature(const uint16_t adc_value);
+static void temp_start_sample(const bool report);
+static void temp_on_conversion(struct adc_pin* self);
+static void temp_start_burst(void);
+static void temp_on_button(struct debounce* self, const bool pressed, const uint32_t press_us);
+static void temp_on_sample_timer(struct sw_timer* self);
+static void temp_on_retry(struct sw_timer* self);
+static void temp_on_vcc_timer(struct sw_timer* self);
 
 /* deklaration av variabeler */
 uint32_t mesure_frequensy; /* frenkvens som anvnds fr att ange hur ofta temperatur lses in och skrivs ut. */
-double avrage_temprature; /* snitt temperatur frn de 5 senaste mtningarna.*/
-bool button_was_pressed; /* variabel som anvnds fr att att aktivera temperaturlsning vid knappnedtryckning.*/
+int16_t avrage_temprature_centi; /* snitt temperatur i hundradels grader frn de TEMP_AVERAGE_SIZE senaste mtningarna.*/
+uint16_t last_adc_value; /* senast avlsta vrdet frn AD-omvandlaren, skickas i binra rapporter.*/
+uint32_t sample_count; /* antal temperaturmtningar sedan start.*/
+uint64_t last_sample_ms; /* drifttid i millisekunder nr senaste mtningen var klar.*/
+volatile bool raw_output_enabled; /* variabel som anger om det ra AD-vrdet ska skrivas ut i textrapporter.*/
+volatile bool sample_pending; /* variabel som anger att en mtning vntar p att AD-omvandlaren blir ledig.*/
+volatile bool report_pending; /* variabel som anger att temperaturen ska skrivas ut nr pgende mtning r klar.*/
+
+/* deklaration av statiska variabler */
+static uint8_t mesure_counter = TEMP_AVERAGE_SIZE; /* antal mtningar som har gjorts sedan senaste knapptryckning.*/
+static uint32_t last_press_us; /* tidpunkt fr senaste knapptryckning mtt i mikrosekunder.*/
+static struct debounce temp_button; /* avstudsning av knappen b1.*/
+static struct sw_timer temp_button_timeout; /* aktiv i TEMP_BUTTON_TIMEOUT_MS efter senaste knapptryckning.*/
+static struct sw_timer temp_sample_timer; /* startar mtningar med aktuell mtfrekvens.*/
+static struct sw_timer temp_retry_timer; /* gr ett nytt frsk om AD-omvandlaren var upptagen.*/
+static struct sw_timer temp_vcc_timer; /* mter matningsspnningen var TEMP_VCC_REFRESH_MS ms.*/
 
 /********************************************************************************
 *
-*	temp_init: intierar variabeln mersure_frequensy och button_was_pressed med
-*			   startvrden s att systemet r redo att kras.
+*	temp_init: intierar variabeln mersure_frequensy med
+*			   startvrden s att systemet r redo att kras. temp_on_conversion
+*			   stts som callback fr AD-omvandlingar av temperatursensorn, som
+*			   versamplas med TEMP_OVERSAMPLE_BITS extra bitar. Om 
+*			   TEMP_INTERNAL_REFERENCE r definierad anvnds den interna 1.1 V-
+*			   referensen, annars mts matningsspnningen en frsta gng.
+*			   Mjukvarutimrarna initieras och startas, s att temperaturen mts
+*			   var mesure_frequensy ms. Knappen avstudsas via temp_button, som
+*			   anropar temp_on_button frn main-loopen vid bekrftad nedtryckning.
 *
 ********************************************************************************/
 void temp_init(void)
 {
 	mesure_frequensy = 60000;
-	button_was_pressed = false;
+	adc_set_callback(&pin2, temp_on_conversion);
+	adc_set_oversampling(&pin2, TEMP_OVERSAMPLE_BITS);
+#ifdef TEMP_INTERNAL_REFERENCE
+	adc_set_reference(&pin2, ADC_REF_INTERNAL);
+#else
+	(void)adc_vcc_measure();
+#endif
+	sw_timer_init(&temp_button_timeout, 0);
+	sw_timer_init(&temp_sample_timer, temp_on_sample_timer);
+	sw_timer_init(&temp_retry_timer, temp_on_retry);
+	sw_timer_init(&temp_vcc_timer, temp_on_vcc_timer);
+
+	debounce_init(&temp_button, &b1, temp_on_button);
+
+	sw_timer_start_ms(&temp_sample_timer, mesure_frequensy, mesure_frequensy);
+#ifndef TEMP_INTERNAL_REFERENCE
+	sw_timer_start_ms(&temp_vcc_timer, TEMP_VCC_REFRESH_MS, TEMP_VCC_REFRESH_MS);
+#endif
 }
 
 /********************************************************************************
 * 
-*	serial_print_temp: skriver ut vrdet fr temperatur och frekvens till ansluten seriel terminal.
+*	serial_print_temp: skriver ut drifttiden fr senaste mtningen samt vrdet fr temperatur
+*					   och frekvens till ansluten seriel terminal.
+*
+*					   Om TEMP_REPORT_BINARY r definierad skickas i stllet en binr
+*					   telemetriram med tidsstmpel (lga 32 bitar av drifttiden fr
+*					   senaste mtningen), senaste AD-vrdet, medeltemperaturen
+*					   i hundradels grader samt mtfrekvensen.
 *
 ********************************************************************************/
 
 void serial_print_temp(void)
 {
+#ifdef TEMP_REPORT_BINARY
+	struct telemetry_frame frame;
+	frame.timestamp_ms = (uint32_t)last_sample_ms;
+	frame.adc_raw = last_adc_value;
+	frame.temp_centi = avrage_temprature_centi;
+	frame.period_ms = mesure_frequensy > UINT16_MAX ? UINT16_MAX : (uint16_t)mesure_frequensy;
+	telemetry_send(&frame);
+#else
+	serial_print_string("time:");
+	serial_print_unsigned64(last_sample_ms);
+	serial_print_string(" ms");
+	serial_print_new_line();
 	serial_print_string("temperature:");
-	serial_print_double(avrage_temprature);
+	serial_print_fixed(avrage_temprature_centi, 2);
 	serial_print_string(" C");
 	serial_print_new_line();
 	serial_print_string("mtfrekvens:");
 	serial_print_integer(mesure_frequensy);
 	serial_print_string(" ms");
 	serial_print_new_line();
+	if (raw_output_enabled)
+	{
+		serial_print_string("adc:");
+		serial_print_unsigned(last_adc_value);
+		serial_print_new_line();
+	}
+#endif
+	return;
+}
+
+/********************************************************************************
+*
+*	temp_set_period: stter ny mtfrekvens i milesekunder. Om ingen serie av mtningar
+*					 efter en knapptryckning pgr startas mttimern om med den nya
+*					 perioden. Eftersom mjukvarutimrarna tas om hand frn main-loopen
+*					 behver avbrott inte inaktiveras.
+*
+*		- period_ms: ny tid melan mtningar i milesekunder.
+*
+********************************************************************************/
+void temp_set_period(const uint32_t period_ms)
+{
+	mesure_frequensy = period_ms;
+	if (mesure_counter >= TEMP_AVERAGE_SIZE)
+	{
+		sw_timer_start_ms(&temp_sample_timer, period_ms, period_ms);
+	}
+	return;
+}
+
+/********************************************************************************
+*
+*	temp_request_report: begr att temperaturen lses in och skrivs ut direkt,
+*						 utan att pverka mtfrekvensen.
+*
+********************************************************************************/
+void temp_request_report(void)
+{
+	temp_start_sample(true);
+	return;
+}
+
+/********************************************************************************
+*
+*	temp_set_raw_output: aktiverar eller inaktiverar utskrift av det ra AD-vrdet.
+*
+*		- enabled: true fr att skriva ut rvrdet, annars false.
+*
+********************************************************************************/
+void temp_set_raw_output(const bool enabled)
+{
+	raw_output_enabled = enabled;
+	return;
+}
+
+/********************************************************************************
+*
+*	temp_print_stats: skriver ut mtfrekvens, medeltemperatur, antal mtningar, 
+*					  uppmtt matningsspnning, antal tecken som har slngts vid sndning och mottagning
+*					  antal hndelser som har slngts p grund av full k, antal
+*					  uppvaknanden ur vilolge samt tid i Power-down och total tid
+*					  sedan start, vilket ger andelen tid som CPU:n har varit vaken.
+*
+********************************************************************************/
+void temp_print_stats(void)
+{
+	serial_print_string("period:");
+	serial_print_unsigned(mesure_frequensy);
+	serial_print_string(" ms\n");
+	serial_print_string("temperature:");
+	serial_print_fixed(avrage_temprature_centi, 2);
+	serial_print_string(" C\n");
+	serial_print_string("samples:");
+	serial_print_unsigned(sample_count);
+	serial_print_string("\nvcc:");
+	serial_print_unsigned(adc_get_vcc_mv());
+	serial_print_string(" mV");
+	serial_print_string("\ntx dropped:");
+	serial_print_unsigned(serial_tx_dropped());
+	serial_print_string("\nrx dropped:");
+	serial_print_unsigned(serial_rx_dropped());
+	serial_print_string("\nevents dropped:");
+	serial_print_unsigned(event_dropped());
+	serial_print_string("\nwakeups:");
+	serial_print_unsigned(timer_get_wakeups());
+	serial_print_string("\npower-down wakeups:");
+	serial_print_unsigned(power_get_wakeups());
+	serial_print_string("\npower-down time:");
+	serial_print_unsigned(power_get_sleep_ms());
+	serial_print_string(" ms\nuptime:");
+	serial_print_unsigned64(timer_uptime_ms());
+	serial_print_string(" ms");
+	serial_print_new_line();
 	return;
 }
 
 /********************************************************************************
 *
-*	temp_get_arave_time: tar emot en variabel som anger en vis tid i milesekunder. placerar in variabel 
-*						 i en array och rknar sedan utt medelvrdet p de fem senaste vrdena placerade i arrayen.
+*	temp_get_arave_time: tar emot en variabel som anger en vis tid i mikrosekunder, som avrundas till
+*						 nrmaste milesekund. placerar in variabel i en array och rknar sedan utt
+*						 medelvrdet p de fem senaste vrdena placerade i arrayen.
 *						 
 *						 De fem frsta vrdena placeras in i arrayen. Nr arrayen r full  flytas vrderna
 *						 i arrayen ett steg uppt och det nya vrdet placeras sedan in lngts ner i arrayen.
@@ -64,105 +222,209 @@ void serial_print_temp(void)
 *						 Medelvrdet fr tiden placeras sedan i mesure_frequensy. och anvnds fr att 
 *						 avgra hur ofta temperaturen skall mtas och skrivas utt.
 *
-*		- new_arage_ms: Det nya vrdet p tiden i milesekunder.
+*		- new_interval_us: Det nya vrdet p tiden i mikrosekunder.
+*		- new_avrage_ms: Det nya vrdet avrundat till milesekunder.
 *
 *		- time_betwen_presses: statisk array dr de 5 senaste tiderna melan knapttryck i milesekunder laggras.
+*		- stored: antal tider som har lagrats i arrayen.
 *
 ********************************************************************************/
-static void temp_get_avrage_time(uint32_t new_avrage_ms)
+static void temp_get_avrage_time(uint32_t new_interval_us)
 {
-	static double time_betwen_presses[5];
-	for (uint8_t i = 0; i < 5 ; i++)
+	const uint32_t new_avrage_ms = (new_interval_us + 500) / 1000;
+	static int32_t time_betwen_presses[5];
+	static uint8_t stored = 0;
+	if (stored < 5)
 	{
-		if (!time_betwen_presses[i])
-		{
-			time_betwen_presses[i] = new_avrage_ms;
-			mesure_frequensy = (uint32_t)(temp_calc_avrg_array_value(time_betwen_presses,i+1)+0.5);
-			return;
-		}
+		time_betwen_presses[stored++] = (int32_t)new_avrage_ms;
+		mesure_frequensy = (uint32_t)temp_calc_avrg_array_value(time_betwen_presses,stored);
+		return;
 	}
 	for (uint8_t i = 0; i < 4 ; i++) time_betwen_presses[i]=time_betwen_presses[i+1];
-	time_betwen_presses[4] = new_avrage_ms;
-	mesure_frequensy = (uint32_t)(temp_calc_avrg_array_value(time_betwen_presses,5)+0.5);
+	time_betwen_presses[4] = (int32_t)new_avrage_ms;
+	mesure_frequensy = (uint32_t)temp_calc_avrg_array_value(time_betwen_presses,5);
 	return;
 }
 
 /********************************************************************************
 *
 *	temp_get_arave_temp: tar emot en variabel som anger en temperatur. placerar in variabel i en array
-*						 och rknar sedan utt medelvrdet p de fem senaste vrdena placerade i arrayen.
+*						 och rknar sedan utt medelvrdet p de TEMP_AVERAGE_SIZE senaste vrdena 
+*						 placerade i arrayen.
 *
-*						 De fem frsta vrdena placeras in i arrayen. Nr arrayen r full flytas sedan vrderna
+*						 De TEMP_AVERAGE_SIZE frsta vrdena placeras in i arrayen. Nr arrayen r full flytas sedan vrderna
 *						 i arrayen ett steg uppt och det nya vrdet placeras sedan in lngst ner i arrayen.
 *
-*						 Medelvrdet fr tiden placeras sedan i avrage_temprature och r det vrdet som skrivs utt
-*						 till en seriel terminal.
+*						 Medelvrdet fr tiden placeras sedan i avrage_temprature_centi och r det vrdet som 
+*						 skrivs utt till en seriel terminal.
 *						
 *
-*		- new_temp:	Det nya vrdet p temperaturen.
+*		- new_temp_centi: Det nya vrdet p temperaturen i hundradels grader.
 *
-*		- avrage_temprature: statisk array dr de 5 senaste temperaturena lagras.
+*		- avrage_temprature: statisk array dr de TEMP_AVERAGE_SIZE senaste temperaturena lagras.
+*		- stored: antal temperaturer som har lagrats i arrayen.
 *
 ********************************************************************************/
-static void temp_get_avrage_temp(double new_temp)
+static void temp_get_avrage_temp(int16_t new_temp_centi)
 {
-	static double avrage_temprature_array[5];
-	for (uint8_t i = 0; i < 5 ; i++)
+	static int32_t avrage_temprature_array[TEMP_AVERAGE_SIZE];
+	static uint8_t stored = 0;
+	if (stored < TEMP_AVERAGE_SIZE)
 	{
-		if (!avrage_temprature_array[i])
-		{
-			avrage_temprature_array[i] = new_temp;
-			avrage_temprature = temp_calc_avrg_array_value(avrage_temprature_array,i+1);
-			return;
-		}
+		avrage_temprature_array[stored++] = new_temp_centi;
+		avrage_temprature_centi = (int16_t)temp_calc_avrg_array_value(avrage_temprature_array,stored);
+		return;
 	}
-	for (uint8_t i = 0; i < 4 ; i++) avrage_temprature_array[i]=avrage_temprature_array[i+1];
-	avrage_temprature_array[4] = new_temp;
-	avrage_temprature = temp_calc_avrg_array_value(avrage_temprature_array,5);
+	for (uint8_t i = 0; i < TEMP_AVERAGE_SIZE - 1 ; i++) avrage_temprature_array[i]=avrage_temprature_array[i+1];
+	avrage_temprature_array[TEMP_AVERAGE_SIZE - 1] = new_temp_centi;
+	avrage_temprature_centi = (int16_t)temp_calc_avrg_array_value(avrage_temprature_array,TEMP_AVERAGE_SIZE);
 }
 
 /********************************************************************************
 *
 *	temp_calc_avrg_array_value: tar emot en array pekare och rknar utt medlevrdet p
-*						        p elementen och returnerar vrdet. antal emlement som 
-*							    skall aderas anges av array_size. 
+*						        p elementen och returnerar vrdet avrundat till nrmaste 
+*								heltal. antal emlement som skall aderas anges av array_size. 
 *
 *		- data_array[]: array vars medelvrde skall skall rknas ut.
 *		- array_size: storlek p arrayen som skikas.
-*		- avrg_valu: anvnds fr att lagra medelvrdet som skall returneras.
+*		- avrg_valu: anvnds fr att lagra summan av elementen.
 *
 ********************************************************************************/
-static inline double temp_calc_avrg_array_value(double data_array[],uint8_t array_size)
+static inline int32_t temp_calc_avrg_array_value(const int32_t data_array[],uint8_t array_size)
 {
-	double avrg_value = 0;
-	for (uint8_t i = 0; i < array_size; i++) avrg_value =+ (avrg_value+data_array[i]);
-	avrg_value = avrg_value / array_size;
-	return  avrg_value;
+	int32_t avrg_value = 0;
+	for (uint8_t i = 0; i < array_size; i++) avrg_value += data_array[i];
+	avrg_value += avrg_value < 0 ? -(int32_t)(array_size / 2) : (int32_t)(array_size / 2);
+	return avrg_value / array_size;
 }
 
 /********************************************************************************
 *
-*	temp_read_temprature: lser av vrdet p en analog pin med hjlp av adc_read 
-*						  och konverterar sedan det vrdet till en temperatur.
-*						  konvertering avser ut vrdet fr en temperatur sensor 
-*						  TMP 36. den utrcknade teperaturen returneras.
+*	temp_calc_temprature: konverterar ett AD-omvandlat vrde till en temperatur i
+*						  hundradels grader. konvertering avser ut vrdet fr en 
+*						  temperatur sensor TMP 36 (10 mV per grad, 500 mV vid 0 grader),
+*						  vilket ger temperaturen 10 * pin_voltage_mv - 5000. den 
+*						  utrcknade teperaturen returneras. Referensspnningen hmtas 
+*						  via adc_reference_mv, dvs. uppmtt matningsspnning eller den 
+*						  interna 1.1 V-referensen. Berkningen sker med heltal, dr 
+*						  10 * adc_value * referensspnningen ryms i 32 bitar.
 *					
-*	- pin_voltage: sparar vrdet fr spningen som ligger p avlst pin.
+*	- adc_value: det AD-omvandlade vrdet frn temperatursensorn, mellan 0 och
+*				 adc_max_value beroende p versampling.
+*	- pin_voltage: sparar tio gnger spningen i mV som ligger p avlst pin.
+*
+********************************************************************************/
+static inline int16_t temp_calc_temprature(const uint16_t adc_value)
+{
+	const uint16_t max_value = adc_max_value(&pin2);
+	const uint32_t pin_voltage = ((uint32_t)adc_value * adc_reference_mv(&pin2) * 10 + max_value / 2) / max_value;
+	return (int16_t)((int32_t)pin_voltage - 5000);
+}
+
+/********************************************************************************
+*
+*	temp_start_sample: startar en AD-omvandling av temperatursensorn utan att vnta 
+*					   p resultatet, som i stllet tas om hand av temp_on_conversion.
+*					   Om AD-omvandlaren r upptagen grs ett nytt frsk vid nsta 
+*					   systemtick via temp_retry_timer. Om TEMP_QUIET_SAMPLING r 
+*					   definierad markeras mtningen i stllet som vntande, se temp_poll.
+*
+*		- report: true om temperaturen ska skrivas ut nr mtningen r klar.
+*
+********************************************************************************/
+static void temp_start_sample(const bool report)
+{
+	if (report) report_pending = true;
+#ifdef TEMP_QUIET_SAMPLING
+	sample_pending = true;
+#else
+	sample_pending = !adc_start(&pin2);
+	if (sample_pending) sw_timer_start(&temp_retry_timer, 1, 0);
+#endif
+	return;
+}
+
+/********************************************************************************
+*
+*	temp_poll: anropas kontinuerligt frn main-loopen. Om TEMP_QUIET_SAMPLING r 
+*			   definierad startas inga mtningar frn systemticken, 
+*			   utan de markeras som vntande och lses av hr via adc_read_quiet.
+*			   Eftersom USART stannar i vilolget ADC Noise Reduction vntar vi 
+*			   tills all data har skickats. Resultatet tas om hand av 
+*			   temp_on_conversion precis som vid vanliga mtningar. Eftersom inget
+*			   avbrott vcker CPU:n nr sista tecknet har skickats returneras true
+*			   s lnge en mtning vntar, s att main-loopen inte gr in i vilolge.
+*
+********************************************************************************/
+bool temp_poll(void)
+{
+#ifdef TEMP_QUIET_SAMPLING
+	if (sample_pending && serial_tx_idle())
+	{
+		sample_pending = false;
+		(void)adc_read_quiet(&pin2);
+	}
+	return sample_pending;
+#else
+	return false;
+#endif
+}
+
+/********************************************************************************
+*
+*	temp_on_conversion: anropas frn main-loopen nr en AD-omvandling
+*						av temperatursensorn r klar. Vrdet sparas, konverteras till 
+*						en temperatur och lggs till medeltemperaturen. Om en utskrift 
+*						har begrts skrivs temperaturen sedan ut.
+*
+*		- self: pekare till den analoga pinnen vars omvandling r klar.
+*		- last_adc_value: det avlsta vrdet sparas fr binra rapporter.
+*		- last_sample_ms: drifttiden nr mtningen var klar, som skickas med i rapporterna.
+*
+********************************************************************************/
+static void temp_on_conversion(struct adc_pin* self)
+{
+	last_adc_value = self->value;
+	last_sample_ms = timer_uptime_ms();
+	sample_count++;
+	temp_get_avrage_temp(temp_calc_temprature(last_adc_value));
+
+	if (report_pending)
+	{
+		report_pending = false;
+		serial_print_temp();
+	}
+	return;
+}
+
+/********************************************************************************
+*
+*	temp_start_burst: startar en serie av TEMP_AVERAGE_SIZE mtningar med perioden 
+*					  mesure_frequensy / TEMP_AVERAGE_SIZE, s att en ny medeltemperatur 
+*					  finns tillgnglig efter en period. Anropas vid knapptryckning.
 *
 ********************************************************************************/
-static inline double temp_read_temprature(void)
+static void temp_start_burst(void)
 {
-	double pin_voltage = (adc_read(&pin2) / 1023.0) * 5;
-	return 100 * pin_voltage - 50;
+	const uint32_t burst_period_ms = mesure_frequensy / TEMP_AVERAGE_SIZE;
+	mesure_counter = 0;
+	sw_timer_start_ms(&temp_sample_timer, burst_period_ms, burst_period_ms);
+	return;
 }
 
 /********************************************************************************
 *
-*	ISR (TIMER0_OVF_vect): Tidsbaserat avbrot som sker varje 128e mirco sekund.
+*	temp_on_button: anropas frn main-loopen nr temp_button har bekrftat att
+*						   knappen har tryckts ned eller slppts. Slpp ignoreras. Tidpunkten
+*						   fr nedtryckningen har tidsstmplats vid frsta flanken med 4 us
+*						   upplsning, s att tiden mellan knapptryckningar varken beror p
+*						   kontaktstudsar eller nr hndelsen tas om hand.
 *
 *						   Vid tv knapptryckningar i fljd inom 60 sekunder s sparas tiden
 *						   melan knapptryckningarna och anvnds fr att rkna utt mtfrekvensen
-*						   fr mtning av temperatur.
+*						   fr mtning av temperatur. temp_button_timeout r aktiv i 
+*						   TEMP_BUTTON_TIMEOUT_MS efter varje knapptryckning.
 *
 *						   Medeltemperaturen frn de 5 senaste knapptryckningarna anvnds fr att
 *						   ange frekvensen fr temperaturmtning och uttskrift.
@@ -171,110 +433,100 @@ static inline double temp_read_temprature(void)
 *						   passerar s terstls systemet och ingen mt frekvens
 *						   lses in.
 *
-*						   Fr att undvika kontaktsttar s lsses inte en knapptryckning in 
-*						   100 milesekunder efter att knappen trycks in.
-*
-*		- button_paused: Variabel som anvnds fr att pausa knapptryck 100 ms efter 
-*						 att knappen trycks ner. 
+*						   CPU:n hlls vaken i TEMP_BUTTON_TIMEOUT_MS efter knapptryckningen,
+*						   s att tiden till nsta knapptryckning mts med systemticken
+*						   ven om TEMP_POWER_DOWN r definierad.
 *
-*		- button_pause_counter:	Variabel som anvnds fr att rkna till antalet avbrot fr
-*								att pausa knappen i 100 ms.
-*
-*		_ button_has_never_ben_presed: variabel som anger om knappen har tryckts
-*									   in dom senaste 60 sekunderna.
+*		- self: pekare till avstudsningen som anropar funktionen (anvnds ej).
+*		- pressed: true vid nedtryckning, false vid slpp.
+*		- press_us: tidpunkten fr flanken mtt i mikrosekunder.
 *									
 ********************************************************************************/
-ISR (TIMER0_OVF_vect)	
+static void temp_on_button(struct debounce* self, const bool pressed, const uint32_t press_us)
 {
-    static bool button_paused = false;
-	static uint16_t button_pause_counter = 0;
-	static bool button_has_never_ben_presed = true;
-	
-	if (button_pause_counter >= timer_get_max_count(100)) 
-	{
-		button_paused = false;
-		button_pause_counter = 0;
-	}
-	if (button_paused) button_pause_counter++; 
-	
-	if (button_is_pressed(&b1) && !button_paused)
-	{
-		button_paused = true;
-		button_was_pressed = true;
-		
-		if(button_has_never_ben_presed) 
-		{
-			button_has_never_ben_presed = false;
-			timer1_button.counter = 0;
-		}
-		else 
-		{
-			temp_get_avrage_time(timer_get_time_elapsed_ms(timer1_button.counter));
-			timer1_button.counter = 0;
-		}
-	}
-	else if (timer1_button.counter >= (timer1_button.max_count))
+	if (!pressed) return;
+
+	if (sw_timer_active(&temp_button_timeout))
 	{
-		timer1_button.counter = 0;
-		button_has_never_ben_presed = true;
+		temp_get_avrage_time(press_us - last_press_us);
 	}
-	timer1_button.counter++;
+
+	last_press_us = press_us;
+	sw_timer_start_ms(&temp_button_timeout, TEMP_BUTTON_TIMEOUT_MS, 0);
+	power_keep_awake(TEMP_BUTTON_TIMEOUT_MS);
+	temp_start_burst();
 	return;
 }
 
-
 /********************************************************************************
 *
-*	ISR (TIMER2_0VF_vect): Tidsbaserat avbrot som sker varje 128e mirco sekund.
+*	temp_on_sample_timer: anropas nr det r dags fr en ny mtning.
 *						   
 *						   Efter initiering s lses lses temperaturen in och skriver utt 
 *						   medeltemperaturen till Seriel terminal varje 60 sekund.
 *
-*						   Vid en knapp trycknings s skrivs medel temperaturen ut. tiden melan 
-*						   mtningar anges av medelvrdet melan knapptryckningar.
+*						   Vid en knapp trycknings s grs TEMP_AVERAGE_SIZE mtningar 
+*						   under en period, varefter medel temperaturen skrivs ut. tiden 
+*						   melan mtningar anges av medelvrdet melan knapptryckningar. 
+*						   Nr serien r klar startas timern om med hela perioden.
 *
-*		- mesure counter: Rknare som anvnds fr att rkna upp till 5 temperaturmtningar
-*						  fr att sedan f en medeltemperatur.
+*						   Mtningar startas via temp_start_sample utan att vnta p
+*						   AD-omvandlaren. Resultatet tas om hand och skrivs ut av
+*						   temp_on_conversion nr omvandlingen r klar.
+*
+*		- self: pekare till timern som anropar funktionen.
 *
 ********************************************************************************/
-ISR (TIMER2_OVF_vect)
+static void temp_on_sample_timer(struct sw_timer* self)
 {
-	static uint8_t mesure_counter = 5;
-	if (button_was_pressed)
-	{
-		mesure_counter = 0;
-		button_was_pressed = false;
-	}
-	
-	if (mesure_counter <= 4 && (uint16_t)(timer_get_max_count(mesure_frequensy)/5+0.5) <= timer2_temp_read.counter)
+	if (mesure_counter < TEMP_AVERAGE_SIZE)
 	{
 		mesure_counter++;
-		temp_get_avrage_temp(temp_read_temprature());
-		timer2_temp_read.counter = 0;
-		if (mesure_counter == 4 ) serial_print_temp();
-	}
-	else if (mesure_counter > 4 && timer_get_max_count(mesure_frequensy) <= timer2_temp_read.counter)
-	{
-		temp_get_avrage_temp(temp_read_temprature());
-		serial_print_temp();
-		timer2_temp_read.counter = 0;
+		temp_start_sample(mesure_counter == TEMP_AVERAGE_SIZE - 1);
+		if (mesure_counter == TEMP_AVERAGE_SIZE)
+		{
+			sw_timer_start_ms(self, mesure_frequensy, mesure_frequensy);
+		}
 	}
-	
-	else if (timer2_temp_read.counter >= timer2_temp_read.max_count)
+	else
 	{
-		temp_get_avrage_temp(temp_read_temprature());
-		serial_print_temp();
-		timer2_temp_read.counter = 0;
+		temp_start_sample(true);
 	}
-	timer2_temp_read.counter++;
 	return;
 }
 
+/********************************************************************************
+*
+*	temp_on_retry: anropas vid systemticken efter att AD-omvandlaren var upptagen 
+*				   och gr ett nytt frsk att starta vntande mtning.
+*
+*		- self: pekare till timern som anropar funktionen.
+*
+********************************************************************************/
+static void temp_on_retry(struct sw_timer* self)
+{
+#ifndef TEMP_QUIET_SAMPLING
+	if (sample_pending) sample_pending = !adc_start(&pin2);
+	if (sample_pending) sw_timer_start(self, 1, 0);
+#endif
+	return;
+}
 
-
-
-
-
-
-
-
+/********************************************************************************
+*
+*	temp_on_vcc_timer: anropas var TEMP_VCC_REFRESH_MS ms och mter matnings-
+*					   spnningen via adc_vcc_refresh. Om AD-omvandlaren r upptagen 
+*					   grs ett nytt frsk vid nsta systemtick, varefter perioden 
+*					   rknas frn det lyckade frsket.
+*
+*		- self: pekare till timern som anropar funktionen.
+*
+********************************************************************************/
+static void temp_on_vcc_timer(struct sw_timer* self)
+{
+	if (!adc_vcc_refresh())
+	{
+		sw_timer_start(self, 1, self->period);
+	}
+	return;
+}
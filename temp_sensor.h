@@ -7,6 +7,53 @@
 #include "timer.h"
 #include "misc.h"
 #include "serial.h"
+#include "telemetry.h"
+#include "power.h"
+#include "debounce.h"
+
+/* Rapportformat: Definiera TEMP_REPORT_BINARY fr att skicka binra
+   telemetriramar (se telemetry.h) i stllet fr text. */
+/* #define TEMP_REPORT_BINARY */
+
+/* Antal extra bitars upplsning via versampling av temperatursensorn (0 - 3),
+   se adc.h. 2 ger 12 bitar (ca 0.12 C per LSB) med 16 omvandlingar per mtning. */
+#ifndef TEMP_OVERSAMPLE_BITS
+#define TEMP_OVERSAMPLE_BITS 2
+#endif
+
+/* Definiera TEMP_INTERNAL_REFERENCE fr att lsa av temperatursensorn med den interna
+   1.1 V-referensen i stllet fr AVcc. Resultatet blir d oberoende av matningsspnningen,
+   men hgsta mtbara temperatur blir ca 60 C (1.1 V). Annars kompenseras resultatet med
+   matningsspnningen, som mts via bandgapreferensen var TEMP_VCC_REFRESH_MS ms. */
+/* #define TEMP_INTERNAL_REFERENCE */
+
+#ifndef TEMP_VCC_REFRESH_MS
+#define TEMP_VCC_REFRESH_MS 5000
+#endif
+
+#define TEMP_BUTTON_TIMEOUT_MS 60000  /* Max tid mellan knapptryckningar som anvnds fr mtfrekvensen. */
+
+/* Definiera TEMP_QUIET_SAMPLING fr att lsa av temperatursensorn frn main-loopen
+   i vilolget ADC Noise Reduction (se adc_read_quiet), vilket ger mindre brus.
+   Medelvrdet kan d berknas ver frre mtningar, s att det stller in sig snabbare. */
+/* #define TEMP_QUIET_SAMPLING */
+
+/* Definiera TEMP_POWER_DOWN fr att frstta CPU:n i vilolget Power-down mellan
+   mtningarna (se power.h), vilket lmpar sig vid batteridrift med lnga mtperioder.
+   Kommandogrnssnittet r d dvt medan CPU:n sover, eftersom USART:ens mottagare
+   saknar klocka i Power-down: tecken som skickas gr frlorade och vcker inte CPU:n.
+   Kommandon tas endast emot nr CPU:n r vaken, dvs. under TEMP_BUTTON_TIMEOUT_MS
+   efter en knapptryckning, och varje mottaget tecken frlnger sedan tiden vaken. */
+/* #define TEMP_POWER_DOWN */
+
+/* Antal mtningar som medeltemperaturen berknas ver. */
+#ifndef TEMP_AVERAGE_SIZE
+#ifdef TEMP_QUIET_SAMPLING
+#define TEMP_AVERAGE_SIZE 3
+#else
+#define TEMP_AVERAGE_SIZE 5
+#endif
+#endif
 
 
 #ifndef TEMP_SENSOR_H_
@@ -16,4 +63,41 @@ void temp_init(void);
 
 void serial_print_temp();
 
+/********************************************************************************
+* temp_poll: Utfr arbete fr temperaturmtningen som ska ske i main-loopen.
+*            Om TEMP_QUIET_SAMPLING r definierad lses vntande mtningar av
+*            hr via adc_read_quiet nr ingen seriell verfring pgr.
+*            Funktionen ska anropas kontinuerligt frn main-loopen och
+*            returnerar true om arbete terstr, s att CPU:n inte ska
+*            frsttas i vilolge.
+********************************************************************************/
+bool temp_poll(void);
+
+/********************************************************************************
+* temp_set_period: Stter ny mtfrekvens, dvs. tiden mellan varje mtning och
+*                  utskrift av temperaturen, mtt i millisekunder.
+*
+*                  - period_ms: Ny tid mellan mtningar mtt i millisekunder.
+********************************************************************************/
+void temp_set_period(const uint32_t period_ms);
+
+/********************************************************************************
+* temp_request_report: Begr att temperaturen lses in och skrivs ut direkt.
+********************************************************************************/
+void temp_request_report(void);
+
+/********************************************************************************
+* temp_set_raw_output: Aktiverar eller inaktiverar utskrift av det ra
+*                      AD-omvandlade vrdet i varje textrapport.
+*
+*                      - enabled: true fr att skriva ut rvrdet, annars false.
+********************************************************************************/
+void temp_set_raw_output(const bool enabled);
+
+/********************************************************************************
+* temp_print_stats: Skriver ut statistik fr temperaturmtningen samt den
+*                   seriella verfringen till ansluten seriell terminal.
+********************************************************************************/
+void temp_print_stats(void);
+
 #endif /* TEMP_SENSOR_H_ */
\ No newline at end of file
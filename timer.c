@@ -11,57 +11,79 @@
 #include "timer.h"
 
 /* Makrodefinitioner: */
-#define TIME_BETWEEN_INTERRUPTS_MS 0.128 /* Tid mellan varje timergenererat avbrott. */
+#define TIMER_IDLE_MARGIN 4 /* Minsta antal upprkningar mellan TCNT1 och nytt vrde p OCR1A. */
+
+/* Statiska variabler: */
+static struct timer* timer_list = 0;         /* Frsta timern i listan, eller 0 om ingen. */
+static volatile uint32_t timer_tick_count = 0; /* Antal systemtickar sedan start. */
+static volatile uint32_t timer_tick_high = 0;  /* Antal gnger timer_tick_count har slagit runt. */
+static uint32_t timer_processed_count = 0;     /* Antal systemtickar som timrarna har rknats upp fr. */
+static volatile uint16_t timer_tick_span = 1;  /* Antal tickar frn TCNT1 = 0 till OCR1A. */
+static volatile uint16_t timer_tick_counted = 0; /* Antal av dessa tickar som redan har rknats in. */
+static uint32_t timer_wakeup_count = 0;        /* Antal uppvaknanden ur vilolge. */
+static bool timer_circuit_initialized = false; /* Indikerar ifall Timer 1 har initierats. */
 
 /* Statiska funktioner: */
-static void timer_init_circuit(struct timer* self);
-static void timer_disable_circuit(struct timer* self);
+static void timer_init_circuit(void);
+static void timer_list_remove(struct timer* self);
+static void timer_on_tick(const struct event* event);
+static void timer_idle_resync(void);
+static inline void timer_tick_advance(const uint32_t ticks);
 
 /********************************************************************************
-* timer_init: Initierar ny timerkrets med angiven tid mtt i millisekunder.
-*             Om timern ska anvndas som rknare fr att rkna upp till ett
-*             specifikt maxvrde br funktionen timer_set_max_count anropas
-*             direkt efter initieringen.
+* timer_init: Initierar ny timer med angiven tid mtt i millisekunder och
+*             lgger till den frst i listan ver timrar. Tillgget sker med
+*             avbrott inaktiverade, s att listan alltid r hel.
+*             Om timern redan finns i listan tas den frst bort. Vid frsta
+*             anropet initieras Timer 1.
 *
-*             - self     : Pekare till timern som ska initieras.
-*             - timer_sel: Val av timerkrets.
-*             - time_ms  : Tiden timern ska sttas p mtt i millisekunder.
+*             - self   : Pekare till timern som ska initieras.
+*             - time_ms: Tiden timern ska sttas p mtt i millisekunder.
 ********************************************************************************/
 void timer_init(struct timer* self, 
-                const enum timer_sel timer_sel, 
-                const double time_ms)
+                const uint32_t time_ms)
 {
+   timer_list_remove(self);
    self->counter = 0;
    self->max_count = timer_get_max_count(time_ms);
-   self->timer_sel = timer_sel;
-   timer_init_circuit(self);
+   self->enabled = false;
+   self->callback = 0;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      self->next = timer_list;
+      timer_list = self;
+   }
+
+   if (!timer_circuit_initialized) timer_init_circuit();
    return;
 }
 
 /********************************************************************************
-* timer_clear: Genomfr total nollstllning av angiven timerkrets.
+* timer_clear: Genomfr total nollstllning av angiven timer och tar bort
+*              den frn listan ver timrar. Systemticken fortstter, eftersom
+*              den delas av samtliga timrar.
 *
 *              - self: Pekare till timern som ska nollstllas.
 ********************************************************************************/
 void timer_clear(struct timer* self)
 {
-   timer_disable_circuit(self);
+   timer_list_remove(self);
    self->counter = 0;
    self->max_count = 0;
-   self->timsk = 0;
-   self->timsk_bit = 0;
-   self->timer_sel = TIMER_EJ_VALD;
+   self->enabled = false;
+   self->callback = 0;
    return;
 }
 
 /********************************************************************************
-* timer_toggle_interrupt: Togglar aktivering av timergenererat avbrott p
-*                         angiven timer. Om avbrott r aktiverat vid anrop sker 
-*                         inaktivering. P samma stt gller att om avbrott r 
-*                         inaktiverat vid anrop s sker aktivering.
+* timer_toggle_interrupt: Togglar aktivering av angiven timer. Om timern r
+*                         aktiverad vid anrop sker inaktivering. P samma stt
+*                         gller att om timern r inaktiverad vid anrop s
+*                         sker aktivering.
 *
-*                         - self: Pekare till timern som aktivering av
-*                                 timergenererat avbrott ska togglas p.
+*                         - self: Pekare till timern som aktivering ska
+*                                 togglas p.
 ********************************************************************************/
 void timer_toggle_interrupt(struct timer* self)
 {
@@ -109,103 +131,379 @@ void timer_reset(struct timer* self)
 }
 
 /********************************************************************************
-* timer_set_new_time: Stter ny tid p angiven timerkrets mtt i millisekunder.
+* timer_set_new_time: Stter ny tid p angiven timer mtt i millisekunder.
 * 
 *                     - self   : Pekare till timern vars tid ska uppdateras.
 *                     - time_ms: Tiden timern ska sttas p i millisekunder.
 ********************************************************************************/
 void timer_set_new_time(struct timer* self, 
-                        const double time_ms)
+                        const uint32_t time_ms)
 {
    self->max_count = timer_get_max_count(time_ms);
    return;
 }
 
 /********************************************************************************
-* timer_init_circuit: Initierar angiven timerkrets. Timer 0 samt Timer 2
-*                     initieras i Normal Mode, medan Timer 1 initieras i
-*                     CTC Mode med upprkning till 256. Vid aktiverat avbrott
-*                     p godtycklig initierad timer sker timergenererat avbrott 
-*                     var 0.128:e millisekund. Adresserna till motsvarande
-*                     maskregister som bit fr aktivering av avbrott sparas.
-*
-*                     - self     : Pekare till timerkretsen som ska initieras.
+* timer_get_ticks: Returnerar antalet systemtickar sedan start. Eftersom
+*                  rknaren r 32 bitar och rknas upp i avbrottsrutinen
+*                  lses den med avbrott inaktiverade.
 ********************************************************************************/
-static void timer_init_circuit(struct timer* self)
+uint32_t timer_get_ticks(void)
 {
-   if (self->timer_sel == TIMER_NR_0)
+   uint32_t ticks;
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
    {
-      TCCR0B = (1 << CS01);
-      self->timsk = &TIMSK0;
-      self->timsk_bit = TOIE0;
+      ticks = timer_tick_count;
    }
-   else if (self->timer_sel == TIMER_NR_1)
+   return ticks;
+}
+
+/********************************************************************************
+* timer_uptime_ticks: Returnerar antalet systemtickar sedan start som ett
+*                     64-bitars vrde, sammansatt av timer_tick_high och
+*                     timer_tick_count.
+********************************************************************************/
+uint64_t timer_uptime_ticks(void)
+{
+   uint64_t ticks;
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
    {
-      TCCR1B = (1 << CS11) | (1 << WGM12);
-      OCR1A = 256;
-      self->timsk = &TIMSK1;
-      self->timsk_bit = OCIE1A;
+      ticks = ((uint64_t)timer_tick_high << 32) | timer_tick_count;
    }
-   else if (self->timer_sel == TIMER_NR_2)
+   return ticks;
+}
+
+/********************************************************************************
+* timer_uptime_ms: Returnerar tiden sedan start mtt i millisekunder. Vid
+*                  hela millisekunder per tick rcker en multiplikation.
+********************************************************************************/
+uint64_t timer_uptime_ms(void)
+{
+#ifdef TIMER_TICK_MS_INT
+   return timer_uptime_ticks() * TIMER_TICK_MS_INT;
+#else
+   return timer_uptime_ticks() * TIMER_TICK_US / 1000UL;
+#endif
+}
+
+/********************************************************************************
+* timer_uptime_us: Returnerar tiden sedan start mtt i mikrosekunder, berknad
+*                  p samma stt som timer_get_us men med 64 bitar.
+********************************************************************************/
+uint64_t timer_uptime_us(void)
+{
+   uint64_t ticks;
+   uint16_t count;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
    {
-      TCCR2B = (1 << CS21);
-      self->timsk = &TIMSK2;
-      self->timsk_bit = TOIE2;
+      count = TCNT1;
+      ticks = (((uint64_t)timer_tick_high << 32) | timer_tick_count) - timer_tick_counted;
+      if ((TIFR1 & (1 << OCF1A)) && count < OCR1A) ticks += timer_tick_span;
    }
+   return ticks * TIMER_TICK_US + (uint32_t)count * TIMER_US_PER_COUNT;
+}
 
-   asm("SEI");
+/********************************************************************************
+* timer_get_us: Returnerar tiden sedan start i mikrosekunder.
+*
+*               1. Med avbrott inaktiverade lser vi TCNT1 samt antalet
+*                  tickar vid start av pgende period fr Timer 1, dvs.
+*                  timer_tick_count minus de tickar i perioden som redan har
+*                  rknats in via timer_idle_resync.
+*
+*               2. Om avbrottet fr systemticken vntar (OCF1A) och TCNT1 r
+*                  mindre n OCR1A har rknaren redan nollstllts, och
+*                  perioden rknas d in hr i stllet fr i avbrottsrutinen.
+*
+*               3. Tiden blir antalet tickar multiplicerat med TIMER_TICK_US
+*                  plus TCNT1 multiplicerat med TIMER_US_PER_COUNT.
+********************************************************************************/
+uint32_t timer_get_us(void)
+{
+   uint32_t ticks;
+   uint16_t count;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      count = TCNT1;
+      ticks = timer_tick_count - timer_tick_counted;
+      if ((TIFR1 & (1 << OCF1A)) && count < OCR1A) ticks += timer_tick_span;
+   }
+   return ticks * TIMER_TICK_US + (uint32_t)count * TIMER_US_PER_COUNT;
+}
+
+/********************************************************************************
+* ISR (TIMER1_COMPA_vect): Avbrottsrutin fr systemticken, som ger rum var
+*                          TIMER_TICK_US:e mikrosekund. Antalet tickar rknas
+*                          upp och en hndelse skickas till main-loopen, dr
+*                          timrarna rknas upp via funktionen timer_on_tick.
+*                          Om avbrottet har flyttats fram via timer_idle rknas
+*                          de tickar under viloperioden som inte redan har
+*                          rknats in via timer_idle_resync, varefter OCR1A
+*                          terstlls till en tick.
+********************************************************************************/
+ISR (TIMER1_COMPA_vect)
+{
+   timer_tick_advance(timer_tick_span - timer_tick_counted);
+   timer_tick_span = 1;
+   timer_tick_counted = 0;
+   OCR1A = TIMER_COMPARE_VALUE;
+   event_post(EVENT_TICK, 0, 0);
    return;
 }
 
 /********************************************************************************
-* timer_disable_circuit: Inaktiverar angiven timerkrets s att varken upprkning
-*                        eller avbrott kan ske. 
+* timer_idle: Frstter CPU:n i vilolget Idle fram till nsta deadline.
+*
+*             1. Antalet tickar begrnsas till TIMER_IDLE_MAX_TICKS, s att
+*                OCR1A ryms i 16 bitar.
+*
+*             2. Med avbrott inaktiverade kontrollerar vi att inga hndelser
+*                vntar, s att ingen hndelse som skickas precis innan
+*                vilolget blir liggande tills nsta uppvaknande.
 *
-*                        - self: Pekare till timern som ska inaktiveras.  
+*             3. Om mer n en tick terstr flyttas avbrottet fr system-
+*                ticken fram genom att OCR1A stts till slutet av sista
+*                ticken. Detta grs endast om OCR1A motsvarar en tick, inget
+*                avbrott vntar (OCF1A) och TCNT1 har minst TIMER_IDLE_MARGIN
+*                upprkningar kvar till OCR1A, annars sover vi endast till
+*                nsta avbrott fr systemticken.
+*
+*             4. Avbrott aktiveras direkt fre instruktionen sleep, vilket
+*                garanterar att sleep exekveras innan ngot avbrott tas om
+*                hand.
+*
+*             5. Efter uppvaknande rknas passerade tickar in via
+*                timer_idle_resync om CPU:n vcktes av ett annat avbrott n
+*                systemticken.
+*
+*             - max_ticks: Antal systemtickar till nsta deadline.
 ********************************************************************************/
-static void timer_disable_circuit(struct timer* self)
+void timer_idle(uint32_t max_ticks)
 {
-   if (self->timer_sel == TIMER_NR_0)
+   if (!max_ticks) return;
+   if (max_ticks > TIMER_IDLE_MAX_TICKS) max_ticks = TIMER_IDLE_MAX_TICKS;
+
+   cli();
+
+   if (event_pending())
    {
-      TCCR0B = 0x00;
-      TIMSK0 = 0x00;
+      sei();
+      return;
    }
-   else if (self->timer_sel == TIMER_NR_1)
+
+   if (max_ticks > 1 && timer_tick_span == 1 && !(TIFR1 & (1 << OCF1A)) &&
+       TCNT1 < TIMER_COMPARE_VALUE - TIMER_IDLE_MARGIN)
+   {
+      OCR1A = (uint16_t)(max_ticks * TIMER_COUNTS_PER_TICK - 1);
+      timer_tick_span = (uint16_t)max_ticks;
+   }
+
+   set_sleep_mode(SLEEP_MODE_IDLE);
+   sleep_enable();
+   sei();
+   sleep_cpu();
+   sleep_disable();
+
+   timer_wakeup_count++;
+   timer_idle_resync();
+   return;
+}
+
+/********************************************************************************
+* timer_add_ticks: Rknar in tickar som har passerat medan Timer 1 stod still.
+*
+*                  1. Tickar som redan har rknats in men inte behandlats
+*                     tas om hand via timer_on_tick, s att deras callbacks
+*                     anropas som vanligt.
+*
+*                  2. Angivet antal tickar lggs till timer_tick_count med
+*                     avbrott inaktiverade och rknas som behandlade.
+*
+*                  3. Varje aktiverad timer rknas upp med samtliga tickar
+*                     p en gng, utan callback. Efter en watchdog-period p
+*                     8 s blir det en addition per timer i stllet fr 8192
+*                     varv genom listan.
+*
+*                  - ticks: Antal systemtickar som har passerat.
+********************************************************************************/
+void timer_add_ticks(const uint32_t ticks)
+{
+   timer_on_tick(0);
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
    {
-      TCCR1B = 0x00;
-      TIMSK1 = 0x00;
-      OCR1A = 0x00;
+      timer_tick_advance(ticks);
    }
-   else if (self->timer_sel == TIMER_NR_2)
+   timer_processed_count += ticks;
+
+   for (struct timer* self = timer_list; self; self = self->next)
    {
-      TCCR2B = 0x00;
-      TIMSK2 = 0x00;
+      if (self->enabled)
+      {
+         ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+         {
+            self->counter += ticks;
+         }
+      }
    }
    return;
 }
 
 /********************************************************************************
-* timer_get_max_count: Returnerar antalet timergenererade avbrott som krvs
-*                      fr angiven tid, avrundad till nrmaste heltal.
-*
-*                      - time_ms: nskad tid mtt i millisekunder.
+* timer_get_wakeups: Returnerar antalet uppvaknanden ur vilolge sedan start.
 ********************************************************************************/
-uint32_t timer_get_max_count(const double time_ms)
+uint32_t timer_get_wakeups(void)
 {
-   return (uint32_t)(time_ms / TIME_BETWEEN_INTERRUPTS_MS + 0.5);
+   return timer_wakeup_count;
 }
 
+/********************************************************************************
+* timer_idle_resync: Rknar in de tickar som har passerat under en viloperiod
+*                    som avbrts av ett annat avbrott n systemticken, s att
+*                    timer_get_ticks och timrarna inte slpar efter.
+*
+*                    1. Om avbrottet fr systemticken redan har skett, eller
+*                       vntar (OCF1A), grs ingenting, eftersom avbrotts-
+*                       rutinen d rknar in samtliga tickar.
+*
+*                    2. Hela tickar som har passerat berknas frn TCNT1, och
+*                       de som inte redan har rknats in lggs till
+*                       timer_tick_count. Nsta avbrott flyttas till slutet
+*                       av pgende tick, eller tick drefter om TCNT1 ligger
+*                       fr nra. Timer 1 rknar hela tiden och nollstlls
+*                       frst vid nsta avbrott, s ingen tid gr frlorad.
+*
+*                    3. Om nsta tickgrns redan r den som OCR1A pekar p
+*                       lmnas OCR1A ofrndrat.
+*
+*                    4. Passerade tickar tas om hand direkt via timer_on_tick,
+*                       eftersom ingen hndelse skickas fr dem.
+********************************************************************************/
+static void timer_idle_resync(void)
+{
+   uint16_t elapsed = 0;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      if (timer_tick_span > 1 && !(TIFR1 & (1 << OCF1A)))
+      {
+         const uint16_t count = TCNT1;
+         const uint16_t passed = count / TIMER_COUNTS_PER_TICK;
+         uint16_t next = passed + 1;
+
+         if (TIMER_COUNTS_PER_TICK - 1 - count % TIMER_COUNTS_PER_TICK < TIMER_IDLE_MARGIN) next++;
+
+         if (next < timer_tick_span)
+         {
+            OCR1A = (uint16_t)((uint32_t)next * TIMER_COUNTS_PER_TICK - 1);
+            timer_tick_span = next;
+         }
+
+         elapsed = passed - timer_tick_counted;
+         timer_tick_counted = passed;
+         timer_tick_advance(elapsed);
+      }
+   }
+
+   if (elapsed) timer_on_tick(0);
+   return;
+}
 
 /********************************************************************************
-* timer_get_time_elapsed: Returnerar hur mycket tid i milesekunder som har gt efter
-						  ett vist antal avbrott, avrundat till nrmaste heltal.
+* timer_on_tick: Anropas frn main-loopen vid hndelse av typen EVENT_TICK.
+*                Listan ver timrar gs igenom en gng fr varje systemtick
+*                som nnu inte har behandlats, vilket jmfrs mot rknaren
+*                timer_tick_count. Drmed tappas inga tickar ven om hndelser
+*                slngs p grund av full k, och efterfljande hndelser blir
+*                tomma anrop. Vid varje tick rknas varje aktiverad timer upp,
+*                varefter eventuell callback anropas. Nsta timer hmtas innan
+*                callbacken anropas, s att callbacken kan ta bort sin egen
+*                timer.
 *
-*						  - counter_value: antal avbrott.
+*                - event: Hndelsen som ska tas om hand (anvnds ej).
 ********************************************************************************/
-uint32_t timer_get_time_elapsed_ms(const uint32_t counter_value)
+static void timer_on_tick(const struct event* event)
 {
-	return (uint32_t)(TIME_BETWEEN_INTERRUPTS_MS * counter_value + 0.5);
+   (void)event;
+
+   while (timer_processed_count != timer_get_ticks())
+   {
+      timer_processed_count++;
+
+      for (struct timer* self = timer_list; self; )
+      {
+         struct timer* next = self->next;
+
+         if (self->enabled)
+         {
+            self->counter++;
+            if (self->callback) self->callback(self);
+         }
+         self = next;
+      }
+   }
+   return;
 }
 
+/********************************************************************************
+* timer_init_circuit: Initierar Timer 1 i CTC Mode via biten WGM12 med
+*                     prescaler 64 via bitarna CS11 och CS10, s att
+*                     rknaren rknar upp till TIMER_COMPARE_VALUE och
+*                     avbrott sker var TIMER_TICK_US:e mikrosekund. Prescaler
+*                     64 gr att OCR1A kan flyttas fram upp till 262 ms vid
+*                     tickless idle. Avbrott vid jmfrelse
+*                     med OCR1A aktiveras via biten OCIE1A. Funktionen
+*                     timer_on_tick stts till att ta om hand systemtickarna.
+********************************************************************************/
+static void timer_init_circuit(void)
+{
+   event_set_handler(EVENT_TICK, timer_on_tick);
+   TCCR1A = 0x00;
+   OCR1A = TIMER_COMPARE_VALUE;
+   TCNT1 = 0;
+   TCCR1B = (1 << WGM12) | (1 << CS11) | (1 << CS10);
+   TIMSK1 |= (1 << OCIE1A);
+   timer_circuit_initialized = true;
+
+   asm("SEI");
+   return;
+}
 
+/********************************************************************************
+* timer_list_remove: Tar bort angiven timer frn listan ver timrar, om den
+*                    finns dr. Sker med avbrott inaktiverade.
+*
+*                    - self: Pekare till timern som ska tas bort.
+********************************************************************************/
+static void timer_list_remove(struct timer* self)
+{
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      for (struct timer** i = &timer_list; *i; i = &(*i)->next)
+      {
+         if (*i == self)
+         {
+            *i = self->next;
+            break;
+         }
+      }
+   }
+   return;
+}
 
+/********************************************************************************
+* timer_tick_advance: Rknar upp timer_tick_count med angivet antal tickar
+*                     och rknar upp timer_tick_high nr rknaren slr runt.
+*                     Anropas med avbrott inaktiverade.
+*
+*                     - ticks: Antal systemtickar som har passerat.
+********************************************************************************/
+static inline void timer_tick_advance(const uint32_t ticks)
+{
+   const uint32_t previous = timer_tick_count;
+   timer_tick_count = previous + ticks;
+   if (timer_tick_count < previous) timer_tick_high++;
+   return;
+}
@@ -8,6 +8,22 @@
 * timer.h: Innehller funktionalitet fr implementering av interruptbaserade 
 *          timerkretsar via strukten timer samt associerade funktioner. 
 *          Dessa timerkretsar fungerar ocks utmrkt att anvnda som rknare.
+*
+*          Samtliga timrar delar p en gemensam systemtick, som genereras av
+*          Timer 1 i CTC Mode var TIMER_TICK_US:e mikrosekund (1 ms som
+*          standard). Avbrottsrutinen TIMER1_COMPA_vect rknar endast upp
+*          antalet tickar och skickar en hndelse av typen EVENT_TICK, se
+*          event.h. Upprkning av varje aktiverad timer samt anrop av
+*          eventuell callback sker sedan frn main-loopen via event_dispatch.
+*          Timer 0 och Timer 2 r drmed lediga, exempelvis fr PWM.
+*
+*          Nr main-loopen saknar arbete kan CPU:n frsttas i vilolget Idle
+*          via timer_idle fram till nsta deadline (tickless idle). Avbrottet
+*          fr systemticken flyttas d fram upp till TIMER_IDLE_MAX_TICKS
+*          tickar, s att CPU:n inte vcks vid varje tick. Om CPU:n vcks
+*          tidigare av ett annat avbrott rknas de tickar som har passerat in
+*          direkt, varefter nsta avbrott flyttas till nsta tickgrns.
+*          Timer 1 rknar hela tiden, s ingen tid gr frlorad.
 ********************************************************************************/
 #ifndef TIMER_H_
 #define TIMER_H_
@@ -15,107 +31,145 @@
 /* Inkluderingsdirektiv: */
 #include "misc.h"
 #include "setup.h"
+#include "event.h"
+
+#ifndef TIMER_TICK_US
+#define TIMER_TICK_US 1000 /* Tid mellan varje systemtick mtt i mikrosekunder. */
+#endif
+
+#define TIMER_PRESCALER 64 /* Prescaler fr Timer 1, ger 4 us upplsning vid 16 MHz. */
+#define TIMER_COUNTS_PER_TICK (F_CPU / 1000UL * TIMER_TICK_US / (TIMER_PRESCALER * 1000UL)) /* Upprkningar av Timer 1 per tick. */
+#define TIMER_COMPARE_VALUE (TIMER_COUNTS_PER_TICK - 1) /* Vrde fr OCR1A. */
+#define TIMER_IDLE_MAX_TICKS (65536UL / TIMER_COUNTS_PER_TICK) /* Max antal tickar per viloperiod (262 vid 1 ms tick). */
+#define TIMER_US_PER_COUNT (TIMER_PRESCALER / (F_CPU / 1000000UL)) /* Upplsning fr TCNT1 mtt i mikrosekunder. */
+
+#if TIMER_TICK_US < 100 || TIMER_COMPARE_VALUE > 65535
+#error "TIMER_TICK_US mste vara mellan 100 och 262144 us!"
+#endif
+
 /********************************************************************************
-* timer_sel: Enumeration fr val av timerkrets.
+* Omvandling mellan tid och systemtickar: Sker med heltalsaritmetik och
+*                                         avrundning till nrmaste heltal.
+*                                         Med konstanta argument berknas
+*                                         resultatet vid kompilering, s att
+*                                         exempelvis TIMER_MS_TO_TICKS(100)
+*                                         blir konstanten 100 vid 1 ms tick.
+*                                         Tiden delas upp i kvot och rest vid
+*                                         division med tickens lngd, s att
+*                                         mellanresultaten ryms i 32 bitar
+*                                         s lnge resultatet gr det.
 ********************************************************************************/
-enum timer_sel
-{
-   TIMER_NR_0,   /* Timer 0. */
-   TIMER_NR_1,   /* Timer 1. */
-   TIMER_NR_2,   /* Timer 2. */
-   TIMER_EJ_VALD /* Timer ej Vald. */
-};
+#if (TIMER_TICK_US % 1000) == 0
+#define TIMER_TICK_MS_INT (TIMER_TICK_US / 1000UL) /* Tid mellan varje systemtick i hela millisekunder. */
+#define TIMER_MS_TO_TICKS(ms) \
+   (((uint32_t)(ms) + TIMER_TICK_MS_INT / 2) / TIMER_TICK_MS_INT)
+#define TIMER_TICKS_TO_MS(ticks) \
+   ((uint32_t)(ticks) * TIMER_TICK_MS_INT)
+#else
+#define TIMER_MS_TO_TICKS(ms) \
+   ((uint32_t)(ms) / TIMER_TICK_US * 1000UL + \
+    ((uint32_t)(ms) % TIMER_TICK_US * 1000UL + TIMER_TICK_US / 2) / TIMER_TICK_US)
+#define TIMER_TICKS_TO_MS(ticks) \
+   ((uint32_t)(ticks) / 1000UL * TIMER_TICK_US + \
+    ((uint32_t)(ticks) % 1000UL * TIMER_TICK_US + 500UL) / 1000UL)
+#endif
+
+#define TIMER_US_TO_TICKS(us) (((uint32_t)(us) + TIMER_TICK_US / 2) / TIMER_TICK_US) /* Mikrosekunder till systemtickar. */
 
 /********************************************************************************
 * timer: Strukt fr implementering av interruptbaserade timerkretsar, som
-*        vid behov kan anvndas som rknare.
+*        vid behov kan anvndas som rknare. Samtliga initierade timrar lagras
+*        i en lnkad lista, som gs igenom vid varje systemtick.
 ********************************************************************************/
 struct timer
 {
-   volatile uint32_t counter; /* 32-bitars rknare. */
-   uint32_t max_count;        /* Maxvrde som upprkning ska ske till. */
-   volatile uint8_t* timsk;   /* Pekare till maskregister fr aktivering av avbrott. */
-   uint8_t timsk_bit;         /* Bit fr aktivering av avbrott i motsvarande maskregister. */
-   enum timer_sel timer_sel;  /* Val av timerkrets. */
+   volatile uint32_t counter;           /* 32-bitars rknare. */
+   uint32_t max_count;                  /* Maxvrde som upprkning ska ske till. */
+   volatile bool enabled;               /* Indikerar ifall timern rknas upp vid varje tick. */
+   void (*callback)(struct timer* self); /* Anropas vid varje tick nr timern r aktiverad (eller 0). */
+   struct timer* next;                  /* Nsta timer i listan. */
 };
 
 /********************************************************************************
-* timer_init: Initierar ny timerkrets med angiven tid mtt i millisekunder.
+* timer_init: Initierar ny timer med angiven tid mtt i millisekunder och
+*             lgger till den i listan ver timrar som rknas upp vid varje
+*             systemtick. Vid frsta anropet startas systemticken. Timern
+*             rknas inte upp frrn den aktiveras via timer_enable_interrupt.
 *             Om timern ska anvndas som rknare fr att rkna upp till ett
 *             specifikt maxvrde br funktionen timer_set_max_count anropas
 *             direkt efter initieringen.
 *
-*             - self     : Pekare till timern som ska initieras.
-*             - timer_sel: Val av timerkrets.
-*             - time_ms  : Tiden timern ska sttas p mtt i millisekunder.
+*             - self   : Pekare till timern som ska initieras.
+*             - time_ms: Tiden timern ska sttas p mtt i millisekunder.
 ********************************************************************************/
 void timer_init(struct timer* self, 
-                const enum timer_sel timer_sel, 
-                const double time_ms);
+                const uint32_t time_ms);
 
 /********************************************************************************
-* timer_clear: Genomfr total nollstllning av angiven timerkrets.
+* timer_clear: Genomfr total nollstllning av angiven timer och tar bort
+*              den frn listan ver timrar.
 *
 *              - self: Pekare till timern som ska nollstllas.
 ********************************************************************************/
 void timer_clear(struct timer* self);
 
 /********************************************************************************
-* timer_enable_interrupt: Aktiverar timergenererat avbrott, som ger rum nr
-*                         timern rknar upp till overflow eller specificerat max.
-*
-*                         Timer 0 samt Timer 2 aktiveras i Normal Mode, medan
-*                         Timer 1 aktiveras i CTC Mode med upprkning till 256,
-*                         vilket gr att tiden mellan varje timergenererat
-*                         avbrott r samma oavsett anvnd timerkrets.
+* timer_set_callback: Stter funktion som ska anropas frn main-loopen vid
+*                     varje systemtick nr timern r aktiverad, efter att
+*                     timern har rknats upp. Funktionen exekverar med avbrott
+*                     aktiverade, men br vara kort, eftersom efterfljande
+*                     tickar annars hinner kas upp.
 *
-*                         Avbrottsvektorer fr timerkretsarna deklareras nedan:
-*
-*                         Timerkrets     Avbrottsvektor
-*                           Timer 0     TIMER0_OVF_vect
-*                           Timer 1     TIMER1_COMPA_vect
-*                           Timer 2     TIMER2_OVF_vect
+*                     - self    : Pekare till timern.
+*                     - callback: Funktion som ska anropas, eller 0 fr ingen.
+********************************************************************************/
+static inline void timer_set_callback(struct timer* self, 
+                                      void (*callback)(struct timer* self))
+{
+   self->callback = callback;
+   return;
+}
+
+/********************************************************************************
+* timer_enable_interrupt: Aktiverar angiven timer, s att den rknas upp och
+*                         eventuell callback anropas vid varje systemtick.
 *
-*                         - self: Pekare till timern som timergenererat
-*                                 avbrott ska aktiveras p.
+*                         - self: Pekare till timern som ska aktiveras.
 ********************************************************************************/
 static inline void timer_enable_interrupt(struct timer* self)
 {
-   *(self->timsk) |= (1 << self->timsk_bit);
+   self->enabled = true;
    return;
 }
 
 /********************************************************************************
-* timer_disable_interrupt: Inaktiverar timergenererat avbrott p angiven timer.
+* timer_disable_interrupt: Inaktiverar angiven timer.
 *
-*                          - self: Pekare till timern som timergenererat
-*                                  avbrott ska inaktiveras p.
+*                          - self: Pekare till timern som ska inaktiveras.
 ********************************************************************************/
 static inline void timer_disable_interrupt(struct timer* self)
 {
-   *(self->timsk) &= ~(1 << self->timsk_bit);
+   self->enabled = false;
    return;
 }
 
 /********************************************************************************
-* timer_toggle_interrupt: Togglar aktivering av timergenererat avbrott p
-*                         angiven timer.
+* timer_toggle_interrupt: Togglar aktivering av angiven timer.
 *
-*                         - self: Pekare till timern som aktivering av 
-*                                 timergenererat avbrott ska togglas p.
+*                         - self: Pekare till timern som aktivering ska
+*                                 togglas p.
 ********************************************************************************/
 void timer_toggle_interrupt(struct timer* self);
 
 /********************************************************************************
-* timer_interrupt_enabled: Indikerar ifall timergenererat avbrott r aktiverat
-*                          p angiven timer.
+* timer_interrupt_enabled: Indikerar ifall angiven timer r aktiverad.
 *
-*                          - self: Pekare till timern vars avbrottstillstnd
-*                                  ska kontrolleras.
+*                          - self: Pekare till timern vars tillstnd ska
+*                                  kontrolleras.
 ********************************************************************************/
 static inline bool timer_interrupt_enabled(const struct timer* self)
 {
-   return (*(self->timsk) & (1 << self->timsk_bit));
+   return self->enabled;
 }
 
 /********************************************************************************
@@ -157,29 +211,127 @@ static inline void timer_reset_counter(struct timer* self)
 void timer_reset(struct timer* self);
 
 /********************************************************************************
-* timer_set_new_time: Stter ny tid p angiven timerkrets.
+* timer_set_new_time: Stter ny tid p angiven timer.
 *
 *                    - self   : Pekare till timern vars tid ska uppdateras.
 *                    - time_ms: Tiden timern ska sttas p mtt i millisekunder.
 ********************************************************************************/
 void timer_set_new_time(struct timer* self, 
-                        const double time_ms);
+                        const uint32_t time_ms);
 						
 /********************************************************************************
-* timer_get_max_count: Returnerar antalet timergenererade avbrott som krvs
-*                      fr angiven tid, avrundad till nrmaste heltal.
+* timer_get_max_count: Returnerar antalet systemtickar som krvs fr angiven
+*                      tid, avrundad till nrmaste heltal, se TIMER_MS_TO_TICKS.
 *
 *                      - time_ms: nskad tid mtt i millisekunder.
 ********************************************************************************/
-uint32_t timer_get_max_count(const double time_ms);
+static inline uint32_t timer_get_max_count(const uint32_t time_ms)
+{
+   return TIMER_MS_TO_TICKS(time_ms);
+}
 
 /********************************************************************************
 * timer_get_time_elapsed: Returnerar hur mycket tid i milesekunder som har gt efter
-						  ett vist antal avbrott, avrundat till nrmaste heltal.
+						  ett vist antal systemtickar, avrundat till nrmaste heltal,
+						  se TIMER_TICKS_TO_MS.
 *
-*						  - counter_value: antal avbrott.
+*						  - counter_value: antal systemtickar.
+********************************************************************************/
+static inline uint32_t timer_get_time_elapsed_ms(const uint32_t counter_value)
+{
+   return TIMER_TICKS_TO_MS(counter_value);
+}
+
+/********************************************************************************
+* timer_get_ticks: Returnerar antalet systemtickar sedan start.
+********************************************************************************/
+uint32_t timer_get_ticks(void);
+
+/********************************************************************************
+* timer_is_after: Indikerar ifall tidpunkten a ligger efter tidpunkten b.
+*                 Jmfrelsen sker via skillnaden med tecken, s att den blir
+*                 rtt ven nr 32-bitars rknare slr runt, s lnge
+*                 tidpunkterna ligger mindre n halva rknarens omfng isr.
+*
+*                 - a: Tidpunkt som ska jmfras, exempelvis i systemtickar.
+*                 - b: Tidpunkt att jmfra mot, i samma enhet som a.
+********************************************************************************/
+static inline bool timer_is_after(const uint32_t a, 
+                                  const uint32_t b)
+{
+   return (int32_t)(b - a) < 0;
+}
+
+/********************************************************************************
+* timer_is_before: Indikerar ifall tidpunkten a ligger fre tidpunkten b,
+*                  se timer_is_after.
+*
+*                  - a: Tidpunkt som ska jmfras.
+*                  - b: Tidpunkt att jmfra mot, i samma enhet som a.
+********************************************************************************/
+static inline bool timer_is_before(const uint32_t a, 
+                                   const uint32_t b)
+{
+   return timer_is_after(b, a);
+}
+
+/********************************************************************************
+* timer_uptime_ticks: Returnerar antalet systemtickar sedan start som ett
+*                     64-bitars vrde, som inte slr runt. Vrdet lses med
+*                     avbrott inaktiverade, s att lga och hga 32 bitar
+*                     hr ihop.
+********************************************************************************/
+uint64_t timer_uptime_ticks(void);
+
+/********************************************************************************
+* timer_uptime_ms: Returnerar tiden sedan start mtt i millisekunder, med
+*                  systemtickens upplsning.
+********************************************************************************/
+uint64_t timer_uptime_ms(void);
+
+/********************************************************************************
+* timer_uptime_us: Returnerar tiden sedan start mtt i mikrosekunder, med
+*                  upplsningen TIMER_US_PER_COUNT, se timer_get_us.
+********************************************************************************/
+uint64_t timer_uptime_us(void);
+
+/********************************************************************************
+* timer_get_us: Returnerar tiden sedan start i mikrosekunder med upplsningen
+*               TIMER_US_PER_COUNT (4 us), berknad frn antalet systemtickar
+*               och aktuellt vrde p TCNT1. Kan anropas frn avbrottsrutiner
+*               fr att tidsstmpla hndelser direkt nr de sker. Vrdet slr
+*               runt efter ca 71 minuter, s tidsskillnader ska berknas med
+*               osignerad aritmetik.
+********************************************************************************/
+uint32_t timer_get_us(void);
+
+/********************************************************************************
+* timer_idle: Frstter CPU:n i vilolget Idle i hgst max_ticks systemtickar,
+*             eller tills ett annat avbrott sker. Om hndelser vntar p att
+*             tas om hand, eller om max_ticks r noll, returnerar funktionen
+*             direkt. Anropas frn main-loopen nr inget arbete terstr.
+*
+*             - max_ticks: Antal systemtickar till nsta deadline.
+********************************************************************************/
+void timer_idle(uint32_t max_ticks);
+
+/********************************************************************************
+* timer_add_ticks: Rknar in tickar som har passerat medan Timer 1 stod
+*                  still, exempelvis i vilolget Power-down, och rknar upp
+*                  aktiverade timrar med samtliga tickar p en gng.
+*                  Timrarnas callbacks anropas inte fr dessa tickar, s
+*                  mjukvarutimrarna mste flyttas fram separat via
+*                  sw_timer_advance. Anropas frn main-loopen.
+*
+*                  - ticks: Antal systemtickar som har passerat.
+********************************************************************************/
+void timer_add_ticks(const uint32_t ticks);
+
+/********************************************************************************
+* timer_get_wakeups: Returnerar antalet gnger CPU:n har vckts ur vilolge
+*                    via timer_idle sedan start.
 ********************************************************************************/
-uint32_t timer_get_time_elapsed_ms(const uint32_t counter_value);
+uint32_t timer_get_wakeups(void);
 
 /********************************************************************************
 * timer_set_new_max_count: Stter nytt maxvrde fr upprkning av timern nr
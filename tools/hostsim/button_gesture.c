@@ -0,0 +1,153 @@
+/********************************************************************************
+* button_gesture.c: Värdsimulering av gesttolkningen i button_gesture.c i
+*                   repots rot, med en tryckknapp på pin 13 (PB5). Main-
+*                   loopen körs som i main.c med sw_timer_idle, medan hw.c
+*                   räknar fram Timer 1. Knappens pin styrs av tabellen
+*                   presses nedan (utan studs, se tools/hostsim/debounce.c)
+*                   och ändras under viloläget via hw_early_wake.
+*
+*                   Förlopp med standardtider (300 / 800 / 200 ms):
+*                   - kort tryck som rapporteras som klick efter double_ms,
+*                   - dubbelklick, där andra släppet sker i läget SECOND,
+*                   - långt tryck med upprepningar, släppt i läget HELD,
+*                   - dubbelklick där andra trycket hålls i 1 s, vilket
+*                     inte ska ge långt tryck.
+*                   Därefter med double_ms = 0 och repeat_ms = 0:
+*                   - kort tryck som rapporteras som klick direkt vid släpp,
+*                   - långt tryck utan upprepningar,
+*                   - två snabba tryck som blir två klick.
+*
+*                   Kontrolleras:
+*                   - varje gest rapporteras på rätt ms med tidpunkten för
+*                     nedtryckningen som inledde gesten, och inga andra
+*                     gester rapporteras,
+*                   - gesttolkningen är i viloläget IDLE efteråt.
+*                   Programmet returnerar 1 om någon kontroll misslyckas.
+********************************************************************************/
+#include "hw.h"
+#include "button_gesture.h"
+#include <stdio.h>
+
+#define PIN_BIT (1 << 5)   /* PB5, pin 13. */
+#define TIMING_CHANGE_MS 5500 /* Tidpunkt då double_ms och repeat_ms sätts till 0. */
+#define END_MS 10000
+
+struct press
+{
+   uint32_t start_ms; /* Nedtryckning. */
+   uint32_t end_ms;   /* Släpp. */
+};
+
+struct expected
+{
+   uint32_t ms;                    /* Tidpunkt för callbacken. */
+   enum button_gesture_type type;  /* Förväntad gest. */
+   uint32_t press_ms;              /* Nedtryckningen som inledde gesten. */
+};
+
+static const struct press presses[] = {
+   { 100, 200 }, { 1000, 1100 }, { 1250, 1350 }, { 2000, 3500 }, { 4000, 4100 }, { 4200, 5200 },
+   { 6000, 6100 }, { 7000, 8500 }, { 9000, 9050 }, { 9150, 9200 } };
+
+static const struct expected expected[] = {
+   { 520, BUTTON_GESTURE_CLICK, 100 },
+   { 1270, BUTTON_GESTURE_DOUBLE, 1000 },
+   { 2820, BUTTON_GESTURE_LONG, 2000 },
+   { 3020, BUTTON_GESTURE_REPEAT, 2000 },
+   { 3220, BUTTON_GESTURE_REPEAT, 2000 },
+   { 3420, BUTTON_GESTURE_REPEAT, 2000 },
+   { 4220, BUTTON_GESTURE_DOUBLE, 4000 },
+   { 6120, BUTTON_GESTURE_CLICK, 6000 },
+   { 7820, BUTTON_GESTURE_LONG, 7000 },
+   { 9070, BUTTON_GESTURE_CLICK, 9000 },
+   { 9220, BUTTON_GESTURE_CLICK, 9150 } };
+
+#define PRESS_COUNT (sizeof(presses) / sizeof(presses[0]))
+#define EXPECTED_COUNT (sizeof(expected) / sizeof(expected[0]))
+
+static const char* const names[] = { "click", "double", "long", "repeat" };
+
+struct button button;
+static struct button_gesture gesture;
+static uint32_t callback_count;
+static bool ok = true;
+
+void PCINT0_vect(void);
+
+/********************************************************************************
+* pin_update: Anropas varje räknesteg i viloläget. Uppdaterar PINB enligt
+*             presses och anropar PCINT0_vect om pinnen har ändrats och är
+*             aktiverad i PCMSK0.
+********************************************************************************/
+static bool pin_update(void)
+{
+   const uint64_t ms = hw_ms();
+   uint8_t level = 0;
+
+   for (uint8_t i = 0; i < PRESS_COUNT; ++i)
+   {
+      if (ms >= presses[i].start_ms && ms < presses[i].end_ms) level = PIN_BIT;
+   }
+
+   if ((PINB & PIN_BIT) == level) return false;
+   PINB = (PINB & ~PIN_BIT) | level;
+   if (!(PCICR & (1 << PCIE0)) || !(PCMSK0 & PIN_BIT)) return false;
+   PCINT0_vect();
+   return true;
+}
+
+/********************************************************************************
+* on_gesture: Jämför gesten med nästa förväntade.
+********************************************************************************/
+static void on_gesture(struct button_gesture* self, const enum button_gesture_type type,
+                       const uint32_t press_us)
+{
+   (void)self;
+   const uint64_t now_ms = hw_ms();
+   const uint32_t i = callback_count++;
+
+   if (i >= EXPECTED_COUNT)
+   {
+      printf("unexpected %s at %llu ms\n", names[type], (unsigned long long)now_ms);
+      ok = false;
+      return;
+   }
+
+   const bool this_ok = type == expected[i].type && now_ms == expected[i].ms &&
+                        press_us == expected[i].press_ms * 1000UL;
+
+   printf("%-6s at %5llu ms (expected %-6s at %5lu ms), press at %lu us %s\n", names[type],
+          (unsigned long long)now_ms, names[expected[i].type], (unsigned long)expected[i].ms,
+          (unsigned long)press_us, this_ok ? "OK" : "FAIL");
+   ok = ok && this_ok;
+   return;
+}
+
+int main(void)
+{
+   bool timing_changed = false;
+
+   OCR1A = TIMER_COMPARE_VALUE;
+   button_init(&button, 13);
+   button_gesture_init(&gesture, &button, on_gesture);
+   hw_early_wake = pin_update;
+
+   while (hw_ms() < END_MS)
+   {
+      if (!timing_changed && hw_ms() >= TIMING_CHANGE_MS)
+      {
+         button_gesture_set_timing(&gesture, 0, BUTTON_GESTURE_LONG_MS, 0);
+         timing_changed = true;
+      }
+      event_dispatch();
+      sw_timer_idle();
+   }
+
+   const bool idle = gesture.state == BUTTON_GESTURE_IDLE;
+   printf("gestures=%lu/%lu, final state %s %s\n", (unsigned long)callback_count,
+          (unsigned long)EXPECTED_COUNT, idle ? "IDLE" : "not IDLE",
+          idle && callback_count == EXPECTED_COUNT ? "OK" : "FAIL");
+
+   ok = ok && idle && callback_count == EXPECTED_COUNT;
+   return ok ? 0 : 1;
+}
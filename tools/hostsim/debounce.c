@@ -0,0 +1,184 @@
+/********************************************************************************
+* debounce.c: Värdsimulering av den avbrottsstyrda avstudsningen i
+*             debounce.c i repots rot, med en tryckknapp på pin 13 (PB5)
+*             som i temp_sensor.c. Main-loopen körs som i main.c med
+*             sw_timer_idle, medan hw.c räknar fram Timer 1.
+*
+*             Knappens pin styrs av pin_level nedan och ändras under
+*             viloläget via hw_early_wake. Om pinnen ändras medan den är
+*             aktiverad i PCMSK0 anropas PCINT0_vect och CPU:n väcks. En
+*             ändring medan pinnen är maskad ger inget avbrott, som i
+*             hårdvaran.
+*
+*             Förlopp (ms):
+*             - 100: nedtryckning med studs var 0.3 ms under 3 ms,
+*             - 400: släpp med studs var 0.5 ms under 5 ms,
+*             - 700: störning, 1 ms hög,
+*             - 1000: nedtryckning utan studs. När insvängningstiden löper
+*               ut släpps knappen mellan första avläsningen och aktiveringen
+*               av PCI-avbrottet i debounce_on_timer, via en omslutning av
+*               button_is_pressed (länkas med --wrap),
+*             - 1200 - 1300: nedtryckning och släpp utan studs, som visar
+*               att knappen inte har blivit kvar maskad.
+*
+*             Kontrolleras:
+*             - callbacken anropas exakt en gång per nedtryckning och
+*               släpp, med rätt läge och inte för störningen,
+*             - tidsstämpeln ligger inom 8 us från första flanken och
+*               callbacken anropas DEBOUNCE_CONFIRM_MS därefter (± 1 ms),
+*             - en studsande flank ger exakt ett avbrott,
+*             - släppet i fönstret ger en callback utan något avbrott.
+*             Programmet returnerar 1 om någon kontroll misslyckas.
+********************************************************************************/
+#include "hw.h"
+#include "debounce.h"
+#include <stdio.h>
+
+#define PIN_BIT (1 << 5)  /* PB5, pin 13. */
+#define RACE_PRESS_US 1000000ULL
+#define RACE_END_US 1100000ULL
+#define END_US 1500000ULL
+
+struct expected
+{
+   bool pressed;      /* Förväntat läge. */
+   uint64_t edge_us;  /* Första flanken, eller 0 för släppet i fönstret. */
+};
+
+static const struct expected expected[] = {
+   { true, 100000 }, { false, 400000 }, { true, 1000000 }, { false, 0 },
+   { true, 1200000 }, { false, 1300000 } };
+#define EXPECTED_COUNT (sizeof(expected) / sizeof(expected[0]))
+
+static const uint64_t burst_us[] = { 100000, 400000, 700000, 1000000, 1200000, 1300000 };
+#define BURST_COUNT (sizeof(burst_us) / sizeof(burst_us[0]))
+
+struct button button;
+static struct debounce debounce;
+static uint64_t race_us = 0;      /* Tidpunkt för släppet i fönstret, eller 0. */
+static uint32_t burst_isr[BURST_COUNT];
+static uint32_t isr_count, callback_count;
+static bool ok = true;
+
+void PCINT0_vect(void);
+bool __real_button_is_pressed(struct button* self);
+
+/********************************************************************************
+* pin_level: Returnerar knappens nivå vid angiven tid, där hög är nedtryckt.
+********************************************************************************/
+static bool pin_level(const uint64_t us)
+{
+   if (us >= 100000 && us < 103000) return ((us - 100000) / 300) % 2 == 0;
+   if (us >= 103000 && us < 400000) return true;
+   if (us >= 400000 && us < 405000) return ((us - 400000) / 500) % 2 == 1;
+   if (us >= 700000 && us < 701000) return true;
+   if (us >= RACE_PRESS_US && us < RACE_END_US) return !race_us || us < race_us;
+   if (us >= 1200000 && us < 1300000) return true;
+   return false;
+}
+
+/********************************************************************************
+* pin_update: Anropas varje räknesteg i viloläget. Uppdaterar PINB och
+*             anropar PCINT0_vect om pinnen har ändrats och är aktiverad.
+********************************************************************************/
+static bool pin_update(void)
+{
+   const uint64_t us = hw_time * 4;
+   const uint8_t level = pin_level(us) ? PIN_BIT : 0;
+
+   if ((PINB & PIN_BIT) == level) return false;
+   PINB = (PINB & ~PIN_BIT) | level;
+   if (!(PCICR & (1 << PCIE0)) || !(PCMSK0 & PIN_BIT)) return false;
+
+   for (uint8_t i = BURST_COUNT; i-- > 0;)
+   {
+      if (us >= burst_us[i])
+      {
+         burst_isr[i]++;
+         break;
+      }
+   }
+   isr_count++;
+   PCINT0_vect();
+   return true;
+}
+
+/********************************************************************************
+* __wrap_button_is_pressed: Läser av knappen. Under nedtryckningen vid
+*                           RACE_PRESS_US släpps knappen direkt efter den
+*                           första avläsning som sker med pinnen maskad
+*                           efter att läget har bekräftats, dvs. mellan
+*                           avläsningen och aktiveringen av avbrottet.
+********************************************************************************/
+bool __wrap_button_is_pressed(struct button* self)
+{
+   const bool pressed = __real_button_is_pressed(self);
+   const uint64_t us = hw_time * 4;
+
+   if (!race_us && us >= RACE_PRESS_US + 5000 && us < RACE_END_US && !(PCMSK0 & PIN_BIT))
+   {
+      race_us = us;
+      PINB &= ~PIN_BIT;
+   }
+   return pressed;
+}
+
+/********************************************************************************
+* on_button: Jämför callbacken med nästa förväntade.
+********************************************************************************/
+static void on_button(struct debounce* self, const bool pressed, const uint32_t time_us)
+{
+   (void)self;
+   const uint64_t now_us = hw_time * 4;
+   const uint32_t i = callback_count++;
+
+   if (i >= EXPECTED_COUNT)
+   {
+      printf("unexpected %s at %llu us\n", pressed ? "press" : "release", (unsigned long long)now_us);
+      ok = false;
+      return;
+   }
+
+   const uint64_t edge_us = expected[i].edge_us ? expected[i].edge_us : race_us;
+   const int64_t stamp_error = (int64_t)time_us - (int64_t)edge_us;
+   const int64_t delay_us = (int64_t)(now_us - edge_us) - DEBOUNCE_CONFIRM_MS * 1000LL;
+   const bool this_ok = pressed == expected[i].pressed && stamp_error >= 0 && stamp_error <= 8 &&
+                        delay_us >= -1000 && delay_us <= 1000;
+
+   printf("%-7s edge %7llu us, stamp %+lld us, callback %+lld us after confirm time %s\n",
+          pressed ? "press" : "release", (unsigned long long)edge_us, (long long)stamp_error,
+          (long long)delay_us, this_ok ? "OK" : "FAIL");
+   ok = ok && this_ok;
+   return;
+}
+
+int main(void)
+{
+   OCR1A = TIMER_COMPARE_VALUE;
+   button_init(&button, 13);
+   debounce_init(&debounce, &button, on_button);
+   hw_early_wake = pin_update;
+
+   while (hw_time * 4 < END_US)
+   {
+      event_dispatch();
+      sw_timer_idle();
+   }
+
+   bool bursts_ok = true;
+   for (uint8_t i = 0; i < BURST_COUNT; ++i)
+   {
+      if (burst_isr[i] != 1) bursts_ok = false;
+   }
+
+   printf("callbacks=%lu/%lu\n", (unsigned long)callback_count, (unsigned long)EXPECTED_COUNT);
+   printf("PCINT0 per burst: %lu %lu %lu %lu %lu %lu, total %lu %s\n",
+          (unsigned long)burst_isr[0], (unsigned long)burst_isr[1], (unsigned long)burst_isr[2],
+          (unsigned long)burst_isr[3], (unsigned long)burst_isr[4], (unsigned long)burst_isr[5],
+          (unsigned long)isr_count, bursts_ok ? "OK" : "FAIL");
+   printf("release between read and unmask at %llu us %s\n", (unsigned long long)race_us,
+          race_us ? "OK" : "FAIL");
+
+   ok = ok && bursts_ok && race_us && callback_count == EXPECTED_COUNT;
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/********************************************************************************
+* format_check.c: Värdkontroll av talformateringen i serial.c, som skriver
+*                 tal utan sprintf via serial_print_digits och serial_divu10.
+*                 serial.c inkluderas direkt, så att även de statiska
+*                 funktionerna kan anropas.
+*
+*                 Kontrolleras:
+*                 - serial_divu10 mot n / 10 och n % 10 för samtliga
+*                   32-bitars tal,
+*                 - utskriften från serial_print_integer, _unsigned,
+*                   _unsigned64 och _fixed mot printf samt
+*                   _double mot förväntad text.
+*
+*                 Utskriften fångas genom att anropa avbrottsrutinen
+*                 USART_UDRE_vect så länge UDRIE0 är ettställd och läsa
+*                 UDR0 efter varje anrop. Programmet returnerar 1 om någon
+*                 kontroll misslyckas.
+********************************************************************************/
+#include "serial.c"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static char output[64];
+static uint8_t output_len;
+static uint32_t failures;
+
+/********************************************************************************
+* capture: Tömmer sändbufferten via USART_UDRE_vect och lagrar tecknen i
+*          output. Vagnreturtecken slängs, eftersom printf inte skriver dem.
+********************************************************************************/
+static const char* capture(void)
+{
+   output_len = 0;
+   while (UCSR0B & (1 << UDRIE0))
+   {
+      USART_UDRE_vect();
+      if ((UCSR0B & (1 << UDRIE0)) && UDR0 != '\r' && output_len < sizeof(output) - 1)
+      {
+         output[output_len++] = UDR0;
+      }
+   }
+   output[output_len] = '\0';
+   return output;
+}
+
+/********************************************************************************
+* expect: Jämför fångad utskrift med förväntad text.
+********************************************************************************/
+static void expect(const char* what, const char* expected)
+{
+   const char* actual = capture();
+   if (strcmp(actual, expected))
+   {
+      if (failures++ < 10) printf("%s: got \"%s\", expected \"%s\"\n", what, actual, expected);
+   }
+   return;
+}
+
+/********************************************************************************
+* check_divu10: Kontrollerar serial_divu10 för samtliga 32-bitars tal.
+********************************************************************************/
+static void check_divu10(void)
+{
+   uint32_t errors = 0;
+   uint32_t n = 0;
+
+   do
+   {
+      uint8_t remainder;
+      const uint32_t quotient = serial_divu10(n, &remainder);
+      if (quotient != n / 10 || remainder != n % 10)
+      {
+         if (errors++ < 10) printf("divu10(%" PRIu32 ") = %" PRIu32 " rest %u\n", n, quotient, remainder);
+      }
+   } while (++n);
+
+   printf("divu10: 2^32 values, %" PRIu32 " errors %s\n", errors, errors ? "FAIL" : "OK");
+   failures += errors;
+   return;
+}
+
+/********************************************************************************
+* check_print: Kontrollerar utskrift av ett urval tal, bl.a. gränsvärden,
+*              tiopotenser med grannar samt pseudoslumpmässiga tal.
+********************************************************************************/
+static void check_print(void)
+{
+   static const int32_t values[] = { 0, 1, -1, 9, 10, -10, 99, 100, 65535, 65536,
+                                     INT32_MAX, INT32_MIN, INT32_MIN + 1 };
+   char expected[64];
+   uint32_t count = 0;
+   uint32_t rng = 1;
+
+   for (int32_t p = 1, i = 0; i < 10; ++i, p = i < 9 ? p * 10 : p)
+   {
+      for (int32_t d = -1; d <= 1; ++d)
+      {
+         const int32_t v = p + d;
+         serial_print_integer(v);
+         snprintf(expected, sizeof(expected), "%" PRId32, v);
+         expect("integer", expected);
+         serial_print_integer(-v);
+         snprintf(expected, sizeof(expected), "%" PRId32, -v);
+         expect("integer", expected);
+         count += 2;
+      }
+   }
+
+   for (uint32_t i = 0; i < 100000 + sizeof(values) / sizeof(values[0]); ++i)
+   {
+      rng = rng * 1103515245UL + 12345UL;
+      const int32_t v = i < sizeof(values) / sizeof(values[0]) ? values[i] : (int32_t)rng;
+
+      serial_print_integer(v);
+      snprintf(expected, sizeof(expected), "%" PRId32, v);
+      expect("integer", expected);
+
+      serial_print_unsigned((uint32_t)v);
+      snprintf(expected, sizeof(expected), "%" PRIu32, (uint32_t)v);
+      expect("unsigned", expected);
+
+      const uint64_t v64 = (uint64_t)(uint32_t)v * rng + (i & 1);
+      serial_print_unsigned64(v64);
+      snprintf(expected, sizeof(expected), "%" PRIu64, v64);
+      expect("unsigned64", expected);
+
+      for (uint8_t decimals = 0; decimals <= SERIAL_MAX_DECIMALS; ++decimals)
+      {
+         uint32_t scale = 1;
+         for (uint8_t j = 0; j < decimals; ++j) scale *= 10;
+         const uint32_t magnitude = v < 0 ? 0UL - (uint32_t)v : (uint32_t)v;
+
+         serial_print_fixed(v, decimals);
+         if (decimals)
+         {
+            snprintf(expected, sizeof(expected), "%s%" PRIu32 ".%0*" PRIu32, v < 0 ? "-" : "",
+                     magnitude / scale, decimals, magnitude % scale);
+         }
+         else
+         {
+            snprintf(expected, sizeof(expected), "%" PRId32, v);
+         }
+         expect("fixed", expected);
+      }
+      count += 3 + SERIAL_MAX_DECIMALS + 1;
+   }
+
+   static const double doubles[] = { 0.0, 1.05, -0.5, 0.004, -0.006, 21.05, -21.056, 123.456, -9999.994 };
+   static const char* const doubles_expected[] = { "0.00", "1.05", "-0.50", "0.00", "-0.01", "21.05",
+                                                   "-21.06", "123.46", "-9999.99" };
+
+   for (uint8_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); ++i)
+   {
+      serial_print_double(doubles[i]);
+      expect("double", doubles_expected[i]);
+      count++;
+   }
+
+   serial_print_string("a\nb");
+   expect("string", "a\nb");
+   count++;
+
+   printf("print: %" PRIu32 " outputs, %" PRIu32 " errors %s\n", count, failures,
+          failures ? "FAIL" : "OK");
+   return;
+}
+
+int main(void)
+{
+   check_print();
+   check_divu10();
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+/********************************************************************************
+* hw.c: Register och modell av Timer 1 samt watchdog-timern, se hw.h.
+********************************************************************************/
+#include "hw.h"
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+/* Register som källkoden läser och skriver: */
+volatile uint8_t PORTB, PORTC, PORTD, PINB, PINC, PIND, DDRB, DDRC, DDRD;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+volatile uint8_t TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, TIMSK2, TIFR2, ASSR;
+volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+volatile uint16_t UBRR0, ADC;
+volatile uint8_t ADMUX, ADCSRA, ADCSRB, DIDR0, ADCL, ADCH;
+volatile uint8_t PCICR, PCMSK0, PCMSK1, PCMSK2, PCIFR, EICRA, EIMSK;
+volatile uint8_t SREG, PRR, MCUSR, WDTCSR, SMCR, MCUCR, ACSR, GPIOR0, GPIOR1, GPIOR2;
+
+int hw_mode;
+uint64_t hw_time = 0;
+uint32_t hw_wdt_wakeups = 0;
+uint32_t hw_early_wakeups = 0;
+bool (*hw_early_wake)(void) = 0;
+
+void TIMER1_COMPA_vect(void);
+
+/* Ersätts av power.c när den länkas in. */
+__attribute__((weak)) void WDT_vect(void) { }
+
+void _delay_ms(double d) { (void)d; }
+void _delay_us(double d) { (void)d; }
+
+/********************************************************************************
+* hw_sleep: Anropas av sleep_cpu.
+*
+*           - Power-down: Timer 1 står still. Tiden räknas fram med watchdog-
+*             timerns period enligt WDTCSR (16 ms * 2^index, utan
+*             oscillatorns avvikelse), varefter WDT_vect anropas.
+*
+*           - Övriga lägen: Timer 1 räknas upp ett steg i taget. Vid
+*             jämförelse med OCR1A nollställs TCNT1 och TIMER1_COMPA_vect
+*             anropas (CTC). Om hw_early_wake returnerar true vaknar CPU:n
+*             utan att systemticken anropas, som vid ett annat avbrott.
+********************************************************************************/
+void hw_sleep(void)
+{
+   if (hw_mode == SLEEP_MODE_PWR_DOWN)
+   {
+      const uint8_t index = (WDTCSR & 0x07) | ((WDTCSR & (1 << WDP3)) ? 0x08 : 0);
+      hw_time += HW_COUNTS_PER_MS * (16UL << index);
+      hw_wdt_wakeups++;
+      WDT_vect();
+      return;
+   }
+
+   for (;;)
+   {
+      hw_time++;
+
+      if (TCNT1 == OCR1A)
+      {
+         TCNT1 = 0;
+         TIMER1_COMPA_vect();
+         return;
+      }
+
+      TCNT1++;
+
+      if (hw_early_wake && hw_early_wake())
+      {
+         hw_early_wakeups++;
+         return;
+      }
+   }
+}
@@ -0,0 +1,34 @@
+/********************************************************************************
+* hw.h: Enkel modell av ATmega328P:s Timer 1 och watchdog-timer för
+*       värdsimuleringar av systemticken och vilolägena. Källkoden körs
+*       oförändrad, medan sleep_cpu anropar hw_sleep, som räknar fram tiden
+*       och anropar avbrottsrutinerna TIMER1_COMPA_vect och WDT_vect.
+*
+*       Exekveringstid modelleras inte: kod mellan två viloperioder tar
+*       ingen simulerad tid. Tiden mäts i Timer 1:s räknesteg (4 us vid
+*       prescaler 64), se HW_COUNTS_PER_MS.
+********************************************************************************/
+#ifndef HW_H_
+#define HW_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HW_COUNTS_PER_MS 250ULL /* Timer 1:s räknesteg per ms vid 16 MHz och prescaler 64. */
+
+extern uint64_t hw_time;            /* Simulerad tid sedan start, mätt i räknesteg. */
+extern uint32_t hw_wdt_wakeups;     /* Antal uppvaknanden via WDT_vect. */
+extern uint32_t hw_early_wakeups;   /* Antal uppvaknanden via hw_early_wake. */
+extern bool (*hw_early_wake)(void); /* Anropas varje räknesteg i Idle, true väcker CPU:n (eller 0). */
+
+void hw_sleep(void);
+
+/********************************************************************************
+* hw_ms: Returnerar simulerad tid sedan start mätt i hela ms.
+********************************************************************************/
+static inline uint64_t hw_ms(void)
+{
+   return hw_time / HW_COUNTS_PER_MS;
+}
+
+#endif /* HW_H_ */
@@ -0,0 +1,8 @@
+#pragma once
+/* Värdstub av <avr/interrupt.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+#define ISR(v, ...) void v(void); void v(void)
+#define sei() do{}while(0)
+#define cli() do{}while(0)
+#define ISR_NOBLOCK
+#define ISR_BLOCK
+#define EMPTY_INTERRUPT(v) void v(void){}
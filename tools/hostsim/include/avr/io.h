@@ -0,0 +1,145 @@
+#pragma once
+/* Värdstub av <avr/io.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+#include <stdint.h>
+#define R8(n) extern volatile uint8_t n;
+#define R16(n) extern volatile uint16_t n;
+R8(PORTB) R8(PORTC) R8(PORTD) R8(PINB) R8(PINC) R8(PIND) R8(DDRB) R8(DDRC) R8(DDRD)
+R8(TCCR0A) R8(TCCR0B) R8(TCNT0) R8(OCR0A) R8(OCR0B) R8(TIMSK0) R8(TIFR0)
+R8(TCCR1A) R8(TCCR1B) R8(TCCR1C) R16(TCNT1) R16(OCR1A) R16(OCR1B) R16(ICR1) R8(TIMSK1) R8(TIFR1)
+R8(TCCR2A) R8(TCCR2B) R8(TCNT2) R8(OCR2A) R8(OCR2B) R8(TIMSK2) R8(TIFR2) R8(ASSR)
+R8(UCSR0A) R8(UCSR0B) R8(UCSR0C) R16(UBRR0) R8(UDR0)
+R8(ADMUX) R8(ADCSRA) R8(ADCSRB) R16(ADC) R8(DIDR0) R8(ADCL) R8(ADCH)
+R8(PCICR) R8(PCMSK0) R8(PCMSK1) R8(PCMSK2) R8(PCIFR) R8(EICRA) R8(EIMSK)
+R8(SREG) R8(PRR) R8(MCUSR) R8(WDTCSR) R8(SMCR) R8(MCUCR) R8(ACSR) R8(GPIOR0) R8(GPIOR1) R8(GPIOR2)
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM00 0
+#define WGM01 1
+#define WGM02 3
+#define COM0A1 7
+#define COM0A0 6
+#define COM0B1 5
+#define COM0B0 4
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+#define TOV0 0
+#define OCF0A 1
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM10 0
+#define WGM11 1
+#define WGM12 3
+#define WGM13 4
+#define COM1A1 7
+#define COM1A0 6
+#define COM1B1 5
+#define COM1B0 4
+#define ICNC1 7
+#define ICES1 6
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM20 0
+#define WGM21 1
+#define WGM22 3
+#define COM2A1 7
+#define COM2A0 6
+#define COM2B1 5
+#define COM2B0 4
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+#define TOV2 0
+#define OCF2A 1
+#define AS2 5
+#define TCN2UB 4
+#define OCR2AUB 3
+#define TCR2AUB 1
+#define TCR2BUB 0
+#define RXC0 7
+#define TXC0 6
+#define UDRE0 5
+#define FE0 4
+#define DOR0 3
+#define UPE0 2
+#define U2X0 1
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0 4
+#define TXEN0 3
+#define UCSZ02 2
+#define UCSZ01 2
+#define UCSZ00 1
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+#define MUX3 3
+#define MUX2 2
+#define MUX1 1
+#define MUX0 0
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define ADTS2 2
+#define ADTS1 1
+#define ADTS0 0
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PRTWI 7
+#define PRTIM2 6
+#define PRTIM0 5
+#define PRTIM1 3
+#define PRSPI 2
+#define PRUSART0 1
+#define PRADC 0
+#define WDIF 7
+#define WDIE 6
+#define WDP3 5
+#define WDCE 4
+#define WDE 3
+#define WDP2 2
+#define WDP1 1
+#define WDP0 0
+#define WDRF 3
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+#define ACD 7
+#define BODS 6
+#define BODSE 5
+#define SREG_I 7
+#define PORTB0 0
+#define PORTB1 1
+#define PORTB2 2
+#define PORTB3 3
+#define PORTB5 5
+#define PORTD3 3
+#define PORTD5 5
+#define PORTD6 6
+#define PINB0 0
+#define _BV(b) (1<<(b))
+#define bit_is_set(r,b) ((r)&_BV(b))
+#define bit_is_clear(r,b) (!((r)&_BV(b)))
+#define loop_until_bit_is_set(r,b) while(bit_is_clear(r,b))
@@ -0,0 +1,6 @@
+#pragma once
+/* Värdstub av <avr/pgmspace.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
@@ -0,0 +1,2 @@
+#pragma once
+/* Värdstub av <avr/power.h> för tools/hostsim, innehåller endast det som källkoden använder. */
@@ -0,0 +1,14 @@
+#pragma once
+/* Värdstub av <avr/sleep.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC 2
+#define SLEEP_MODE_PWR_DOWN 4
+#define SLEEP_MODE_PWR_SAVE 6
+extern int hw_mode;
+#define set_sleep_mode(m) (hw_mode = (m))
+#define sleep_enable() do{}while(0)
+#define sleep_disable() do{}while(0)
+extern void hw_sleep(void);
+#define sleep_cpu() hw_sleep() /* Modellen av Timer 1 och watchdog-timern i hw.c. */
+#define sleep_mode() do{}while(0)
+#define sleep_bod_disable() do{}while(0)
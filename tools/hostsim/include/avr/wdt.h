@@ -0,0 +1,10 @@
+#pragma once
+/* Värdstub av <avr/wdt.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+#define WDTO_15MS 0
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+#define wdt_reset() do{}while(0)
+#define wdt_disable() do{}while(0)
+#define wdt_enable(x) ((void)(x))
@@ -0,0 +1 @@
+#define asm(...) ((void)0) /* Inline-assembler (SEI) ignoreras på värddatorn. */
@@ -0,0 +1,7 @@
+#pragma once
+/* Värdstub av <util/atomic.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 1
+#define NONATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(t) for(int _ab=1;_ab;_ab=0)
+#define NONATOMIC_BLOCK(t) for(int _ab=1;_ab;_ab=0)
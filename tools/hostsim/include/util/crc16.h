@@ -0,0 +1,5 @@
+#pragma once
+/* Värdstub av <util/crc16.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+#include <stdint.h>
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data){crc^=(uint16_t)data<<8;for(int i=0;i<8;i++)crc=(crc&0x8000)?(crc<<1)^0x1021:(crc<<1);return crc;}
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data){(void)data;return crc;}
@@ -0,0 +1,4 @@
+#pragma once
+/* Värdstub av <util/delay.h> för tools/hostsim, innehåller endast det som källkoden använder. */
+void _delay_ms(double);
+void _delay_us(double);
@@ -0,0 +1,188 @@
+/********************************************************************************
+* led_pattern.c: Värdsimulering av blinkmönstren i led_pattern.c i repots
+*                rot. Två mönster spelas samtidigt med 100 ms per steg:
+*                - LED_PATTERN_CHASE på fyra lysdioder på pin 8 - 11
+*                  (PB0 - PB3),
+*                - LED_PATTERN_HEARTBEAT på två lysdioder på pin 2 - 3
+*                  (PD2 - PD3).
+*                Main-loopen körs som i main.c med sw_timer_idle, medan hw.c
+*                räknar fram Timer 1.
+*
+*                Förlopp (ms):
+*                - 450: de två sista lysdioderna i jagande mönstret tas bort
+*                  med led_vect_pop medan mönstret går bakåt på steg 2, dvs.
+*                  utanför den krympta vektorn. CPU:n väcks via hw_early_wake,
+*                  som vid ett annat avbrott.
+*                - 1500: hjärtslaget startas om med step_ms = 0.
+*
+*                Kontrolleras:
+*                - PORTB och PORTD ändras på rätt ms till rätt värden fram
+*                  till 1200 ms, inklusive omstarten framåt från första
+*                  lysdioden efter att vektorn har krympt,
+*                - de borttagna lysdioderna tänds aldrig efter 450 ms,
+*                - hjärtslaget med step_ms = 0 fortsätter med en systemtick
+*                  per steg, dvs. fyra ändringar av PORTD per 8 ms.
+*                Programmet returnerar 1 om någon kontroll misslyckas.
+********************************************************************************/
+#include "hw.h"
+#include "led_pattern.h"
+#include <stdio.h>
+
+#define POP_MS 450        /* Tidpunkt då två lysdioder tas bort. */
+#define LOG_END_MS 1200   /* Ändringar loggas och jämförs fram till denna tidpunkt. */
+#define ZERO_STEP_MS 1500 /* Tidpunkt då hjärtslaget startas om med step_ms = 0. */
+#define ZERO_STEP_WINDOW_MS 80
+#define END_MS 1600
+#define CHASE_MASK 0x0F     /* PB0 - PB3. */
+#define POPPED_MASK 0x0C    /* PB2 - PB3, tas bort vid POP_MS. */
+#define HEARTBEAT_MASK 0x0C /* PD2 - PD3. */
+
+struct change
+{
+   uint32_t ms;   /* Tidpunkt för ändringen. */
+   uint8_t value; /* Portens värde efter ändringen. */
+};
+
+static const struct change expected_b[] = {
+   { 0, 0x01 }, { 100, 0x02 }, { 200, 0x04 }, { 300, 0x08 }, { 400, 0x04 }, { 450, 0x00 },
+   { 500, 0x01 }, { 600, 0x02 }, { 700, 0x01 }, { 800, 0x02 }, { 900, 0x01 }, { 1000, 0x02 },
+   { 1100, 0x01 } };
+
+static const struct change expected_d[] = {
+   { 0, 0x0C }, { 100, 0x00 }, { 200, 0x0C }, { 300, 0x00 }, { 800, 0x0C }, { 900, 0x00 },
+   { 1000, 0x0C }, { 1100, 0x00 } };
+
+#define EXPECTED_B_COUNT (sizeof(expected_b) / sizeof(expected_b[0]))
+#define EXPECTED_D_COUNT (sizeof(expected_d) / sizeof(expected_d[0]))
+#define LOG_SIZE 32
+
+LED_VECT_DEFINE(chase_vect, 4);
+LED_VECT_DEFINE(heartbeat_vect, 2);
+static struct led_pattern chase, heartbeat;
+
+static struct change log_b[LOG_SIZE], log_d[LOG_SIZE];
+static uint8_t log_b_count, log_d_count;
+static uint8_t last_b, last_d;
+static uint32_t popped_lit, zero_step_changes;
+static bool popped;
+
+/********************************************************************************
+* early_pop: Väcker CPU:n vid POP_MS, så att lysdioderna tas bort mitt
+*            mellan två steg.
+********************************************************************************/
+static bool early_pop(void)
+{
+   return !popped && hw_time == POP_MS * HW_COUNTS_PER_MS;
+}
+
+/********************************************************************************
+* sample: Läser av PORTB och PORTD och loggar ändringar med aktuell tid.
+********************************************************************************/
+static void sample(void)
+{
+   const uint32_t ms = (uint32_t)hw_ms();
+   const uint8_t b = PORTB & CHASE_MASK;
+   const uint8_t d = PORTD & HEARTBEAT_MASK;
+
+   if (popped && (b & POPPED_MASK)) popped_lit++;
+
+   if (ms < LOG_END_MS)
+   {
+      if (b != last_b && log_b_count < LOG_SIZE) log_b[log_b_count++] = (struct change){ ms, b };
+      if (d != last_d && log_d_count < LOG_SIZE) log_d[log_d_count++] = (struct change){ ms, d };
+   }
+   else if (ms >= ZERO_STEP_MS && ms < ZERO_STEP_MS + ZERO_STEP_WINDOW_MS && d != last_d)
+   {
+      zero_step_changes++;
+   }
+
+   last_b = b;
+   last_d = d;
+   return;
+}
+
+/********************************************************************************
+* compare: Jämför loggade ändringar med förväntade och skriver ut dem.
+********************************************************************************/
+static bool compare(const char* port, const struct change* log, const uint8_t log_count,
+                    const struct change* expected, const uint8_t expected_count)
+{
+   bool ok = log_count == expected_count;
+
+   for (uint8_t i = 0; i < log_count || i < expected_count; ++i)
+   {
+      const bool this_ok = i < log_count && i < expected_count && log[i].ms == expected[i].ms &&
+                           log[i].value == expected[i].value;
+      printf("%s change %2u: ", port, i);
+      if (i < log_count) printf("%4lu ms 0x%02X", (unsigned long)log[i].ms, log[i].value);
+      else printf("%-12s", "-");
+      if (i < expected_count) printf(" (expected %4lu ms 0x%02X)", (unsigned long)expected[i].ms,
+                                     expected[i].value);
+      printf(" %s\n", this_ok ? "OK" : "FAIL");
+      ok = ok && this_ok;
+   }
+   return ok;
+}
+
+int main(void)
+{
+   struct led led;
+   bool zero_step_started = false;
+
+   OCR1A = TIMER_COMPARE_VALUE;
+
+   for (uint8_t pin = 8; pin <= 11; ++pin)
+   {
+      led_init(&led, pin);
+      led_vect_push(&chase_vect, &led);
+   }
+   for (uint8_t pin = 2; pin <= 3; ++pin)
+   {
+      led_init(&led, pin);
+      led_vect_push(&heartbeat_vect, &led);
+   }
+
+   led_pattern_init(&chase, &chase_vect);
+   led_pattern_init(&heartbeat, &heartbeat_vect);
+   led_pattern_start(&chase, LED_PATTERN_CHASE, 100);
+   led_pattern_start(&heartbeat, LED_PATTERN_HEARTBEAT, 100);
+   hw_early_wake = early_pop;
+
+   while (hw_ms() < END_MS)
+   {
+      event_dispatch();
+
+      if (!popped && hw_ms() >= POP_MS)
+      {
+         printf("pop at %lu ms: step %u of %u, %s\n", (unsigned long)hw_ms(), chase.step,
+                chase_vect.size, chase.reverse ? "reverse" : "forward");
+         led_vect_pop(&chase_vect);
+         led_vect_pop(&chase_vect);
+         popped = true;
+      }
+      if (!zero_step_started && hw_ms() >= ZERO_STEP_MS)
+      {
+         led_pattern_start(&heartbeat, LED_PATTERN_HEARTBEAT, 0);
+         zero_step_started = true;
+      }
+
+      sample();
+      sw_timer_idle();
+      sample();
+   }
+
+   bool ok = compare("PORTB", log_b, log_b_count, expected_b, EXPECTED_B_COUNT);
+   ok = compare("PORTD", log_d, log_d_count, expected_d, EXPECTED_D_COUNT) && ok;
+
+   const bool popped_ok = popped && !popped_lit;
+   const bool zero_step_ok = led_pattern_active(&heartbeat) &&
+                             zero_step_changes == ZERO_STEP_WINDOW_MS / 2;
+
+   printf("popped LEDs lit after pop: %lu %s\n", (unsigned long)popped_lit, popped_ok ? "OK" : "FAIL");
+   printf("step_ms = 0: %lu PORTD changes in %u ms (expected %u), %s %s\n",
+          (unsigned long)zero_step_changes, ZERO_STEP_WINDOW_MS, ZERO_STEP_WINDOW_MS / 2,
+          led_pattern_active(&heartbeat) ? "active" : "stopped", zero_step_ok ? "OK" : "FAIL");
+
+   ok = ok && popped_ok && zero_step_ok;
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/********************************************************************************
+* oversample.c: Värdbenchmark av översampling och decimering i adc.c (se
+*               adc_set_oversampling) på en TMP36-liknande insignal.
+*
+*               Temperaturen svepas från 15 till 35 °C i steg om 0.01 °C.
+*               För varje steg startas en omvandling via adc_start, varefter
+*               avbrottsrutinen ADC_vect anropas med ett nytt värde i ADC
+*               tills omvandlingen är klar, som i free running mode. Värdet
+*               beräknas som en ideal 10-bitars AD-omvandlare med AVcc = 5 V
+*               och normalfördelat brus med angiven standardavvikelse.
+*
+*               Rapporteras för n = 0 - 3 extra bitar och olika brusnivåer:
+*               - omvandlingar per resultat (räknat) och resultat per sekund
+*                 vid 125 kHz AD-klocka och 13 klockcykler per omvandling,
+*               - °C per LSB i resultatet,
+*               - RMS-fel i °C efter borttagen konstant offset, som
+*                 motsvarar en kalibrering,
+*               - effektiv upplösning i bitar, beräknad som 10 bitar plus
+*                 log2 av RMS-felet utan översampling delat med RMS-felet.
+*
+*               Kontrolleras:
+*               - att varje resultat består av exakt 4^n omvandlingar,
+*               - att översampling med minst 1 LSB brus ger minst n - 0.5
+*                 extra effektiva bitar.
+*               Programmet returnerar 1 om någon kontroll misslyckas.
+********************************************************************************/
+#include "hw.h"
+#include "adc.h"
+#include <math.h>
+#include <stdio.h>
+
+#define OVERSAMPLE_VREF_MV 5000.0    /* AVcc. */
+#define OVERSAMPLE_CONVERSIONS_PER_S (125000.0 / 13.0) /* 125 kHz AD-klocka, 13 cykler per omvandling. */
+#define OVERSAMPLE_T_MIN 15.0        /* Svepets starttemperatur i °C. */
+#define OVERSAMPLE_STEPS 2001        /* Antal steg om 0.01 °C. */
+
+static uint32_t rng = 12345;
+
+void ADC_vect(void);
+
+/********************************************************************************
+* gauss: Returnerar ett normalfördelat slumptal med medelvärde 0 och
+*        standardavvikelse 1 (Box-Muller).
+********************************************************************************/
+static double gauss(void)
+{
+   rng = rng * 1103515245UL + 12345UL;
+   const double u1 = ((rng >> 8) + 1.0) / 16777217.0;
+   rng = rng * 1103515245UL + 12345UL;
+   const double u2 = (rng >> 8) / 16777216.0;
+   return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/********************************************************************************
+* convert: Returnerar en ideal 10-bitars omvandling av angiven spänning med
+*          angivet brus mätt i LSB.
+********************************************************************************/
+static uint16_t convert(const double mv, const double noise_lsb)
+{
+   const double code = floor(mv * 1024.0 / OVERSAMPLE_VREF_MV + noise_lsb * gauss());
+   return code < 0 ? 0 : code > 1023 ? 1023 : (uint16_t)code;
+}
+
+/********************************************************************************
+* sweep: Sveper temperaturen med angivet antal extra bitar och brus och
+*        returnerar RMS-felet i °C efter borttagen offset. Antalet
+*        omvandlingar per resultat lagras på angiven adress, eller 0 om
+*        resultaten bestod av olika många omvandlingar.
+********************************************************************************/
+static double sweep(const uint8_t bits, const double noise_lsb, uint32_t* per_result)
+{
+   static struct adc_pin pin;
+   static double error[OVERSAMPLE_STEPS];
+   double mean = 0, sum_square = 0;
+
+   adc_init(&pin, 2);
+   adc_set_oversampling(&pin, bits);
+   *per_result = 0;
+
+   for (uint32_t i = 0; i < OVERSAMPLE_STEPS; ++i)
+   {
+      const double t = OVERSAMPLE_T_MIN + i * 0.01;
+      const double mv = 500.0 + 10.0 * t;
+      uint32_t conversions = 0;
+
+      adc_start(&pin);
+      while (adc_busy())
+      {
+         ADC = convert(mv, noise_lsb);
+         ADC_vect();
+         conversions++;
+      }
+
+      if (i == 0) *per_result = conversions;
+      else if (*per_result != conversions) *per_result = 0;
+
+      const double measured_mv = (pin.value + 0.5) * OVERSAMPLE_VREF_MV / (1024.0 * (1 << bits));
+      error[i] = (measured_mv - 500.0) / 10.0 - t;
+      mean += error[i];
+   }
+
+   mean /= OVERSAMPLE_STEPS;
+   for (uint32_t i = 0; i < OVERSAMPLE_STEPS; ++i)
+   {
+      sum_square += (error[i] - mean) * (error[i] - mean);
+   }
+   return sqrt(sum_square / OVERSAMPLE_STEPS);
+}
+
+int main(void)
+{
+   static const double noise[] = { 0.0, 0.5, 1.0, 2.0 };
+   bool ok = true;
+
+   for (uint8_t i = 0; i < sizeof(noise) / sizeof(noise[0]); ++i)
+   {
+      double rms_10bit = 0;
+      printf("noise %.1f LSB:\n", noise[i]);
+
+      for (uint8_t bits = 0; bits <= ADC_OVERSAMPLE_MAX_BITS; ++bits)
+      {
+         uint32_t per_result;
+         const double rms = sweep(bits, noise[i], &per_result);
+         if (!bits) rms_10bit = rms;
+
+         const double gain = rms > 0 ? log2(rms_10bit / rms) : 0;
+         const bool count_ok = per_result == (1UL << (2 * bits));
+         const bool gain_ok = noise[i] < 1.0 || gain >= bits - 0.5;
+         ok = ok && count_ok && gain_ok;
+
+         printf("  n=%u: %2u bit, %2lu conversions/result, %4.0f results/s, "
+                "%.3f C/LSB, rms error %.3f C, effective %.1f bit %s\n",
+                bits, 10 + bits, (unsigned long)per_result,
+                per_result ? OVERSAMPLE_CONVERSIONS_PER_S / per_result : 0.0,
+                OVERSAMPLE_VREF_MV / 1024.0 / 10.0 / (1 << bits), rms, 10 + gain,
+                count_ok && gain_ok ? "OK" : "FAIL");
+      }
+   }
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/********************************************************************************
+* power_down.c: Värdsimulering av viloläget Power-down (se power.h) med
+*               samma timrar som temp_sensor.c med TEMP_POWER_DOWN: en
+*               mättimer på 60 s och en timer för matningsspänningen på 5 s.
+*               Main-loopen anropar power_sleep som i main.c.
+*
+*               Kontrolleras:
+*               - varje mätning sker på rätt ms,
+*               - att power_keep_awake och Power-down fungerar även när
+*                 antalet systemtickar har passerat 2^31 (ca 24.8 dygn):
+*                 inget Power-down under 5 s efter power_keep_awake, men
+*                 Power-down under efterföljande minut.
+*               Rapporteras:
+*               - uppvaknanden per minut via watchdog-timern och Timer 1,
+*               - antal varv genom timerlistan per uppvaknande via
+*                 watchdog-timern, räknat med en extra timer i listan,
+*               - uppskattad tid vaken och andel av tiden i Power-down.
+*
+*               Exekveringstid modelleras inte av hw.c, så tiden vaken
+*               uppskattas med konstanterna nedan, som är antaganden och
+*               inte mätningar, och läggs till den simulerade tiden. Tid i
+*               Idle är tid mellan uppvaknanden via Timer 1. Programmet
+*               returnerar 1 om någon kontroll misslyckas.
+********************************************************************************/
+#include "hw.h"
+#include "power.h"
+#include "sw_timer.h"
+#include <stdio.h>
+
+#define POWER_DOWN_MINUTES 60
+
+/* Antaganden för uppskattad tid vaken: */
+#define STARTUP_US 1000         /* Kristalloscillatorns start, 16K CK vid 16 MHz (Unos säkringar). */
+#define CYCLES_PER_WAKE 2000    /* WDT-avbrott, power_down, sw_timer_ticks_to_next m.m. */
+#define CYCLES_PER_PASS 80      /* Ett varv genom timerlistan inklusive sw_timer_tick. */
+#define CYCLES_PER_IDLE_WAKE 3000 /* Uppvaknande ur Idle inklusive mätning och utskrift. */
+
+static struct sw_timer sample_timer;
+static struct sw_timer vcc_timer;
+static struct timer probe;
+static uint32_t sample_count;
+static int64_t max_error_ms;
+static uint64_t passes;
+
+bool serial_tx_idle(void) { return true; }
+bool adc_busy(void) { return false; }
+
+static void on_sample(struct sw_timer* self)
+{
+   (void)self;
+   int64_t error = (int64_t)hw_ms() - (int64_t)(60000ULL * ++sample_count);
+   if (error < 0) error = -error;
+   if (error > max_error_ms) max_error_ms = error;
+   return;
+}
+
+static void on_vcc(struct sw_timer* self)
+{
+   (void)self;
+   return;
+}
+
+static void on_probe(struct timer* self)
+{
+   (void)self;
+   passes++;
+   return;
+}
+
+int main(void)
+{
+   OCR1A = TIMER_COMPARE_VALUE;
+   PRR = (1 << PRTIM0) | (1 << PRTIM2);
+
+   timer_init(&probe, 0);
+   timer_set_callback(&probe, on_probe);
+   timer_enable_interrupt(&probe);
+
+   sw_timer_init(&sample_timer, on_sample);
+   sw_timer_init(&vcc_timer, on_vcc);
+   sw_timer_start_ms(&sample_timer, 60000, 60000);
+   sw_timer_start_ms(&vcc_timer, 5000, 5000);
+
+   while (hw_ms() <= POWER_DOWN_MINUTES * 60000ULL)
+   {
+      event_dispatch();
+      power_sleep(sw_timer_ticks_to_next());
+   }
+
+   const double total_ms = (double)hw_ms();
+   const double wdt_wakes = power_get_wakeups();
+   const double idle_wakes = timer_get_wakeups();
+   const double awake_ms = wdt_wakes * STARTUP_US / 1000.0 +
+                           (wdt_wakes * CYCLES_PER_WAKE + (double)passes * CYCLES_PER_PASS +
+                            idle_wakes * CYCLES_PER_IDLE_WAKE) / (F_CPU / 1000.0);
+   const double idle_ms = total_ms - power_get_sleep_ms();
+   const double real_ms = total_ms + awake_ms;
+   bool ok = max_error_ms == 0 && sample_count == POWER_DOWN_MINUTES;
+
+   printf("%d min: samples=%lu max error=%lld ms\n", POWER_DOWN_MINUTES,
+          (unsigned long)sample_count, (long long)max_error_ms);
+   printf("wakeups/min: watchdog=%.1f idle=%.1f\n", wdt_wakes / POWER_DOWN_MINUTES,
+          idle_wakes / POWER_DOWN_MINUTES);
+   printf("timer list passes: %llu total, %.1f per watchdog wakeup\n",
+          (unsigned long long)passes, passes / wdt_wakes);
+   printf("power-down %.3f %%, idle %.3f %%, awake (estimated) %.3f %% = %.1f ms/min %s\n",
+          100.0 * power_get_sleep_ms() / real_ms, 100.0 * idle_ms / real_ms,
+          100.0 * awake_ms / real_ms, awake_ms / POWER_DOWN_MINUTES, ok ? "OK" : "FAIL");
+
+   timer_add_ticks(0x80000000UL);
+   power_keep_awake(5000);
+   const uint64_t start_ms = hw_ms();
+   const uint32_t start_wakeups = power_get_wakeups();
+   uint32_t kept_awake_wakeups = 0;
+
+   while (hw_ms() <= start_ms + 65000)
+   {
+      if (hw_ms() < start_ms + 5000) kept_awake_wakeups = power_get_wakeups() - start_wakeups;
+      event_dispatch();
+      power_sleep(sw_timer_ticks_to_next());
+   }
+
+   const uint32_t late_wakeups = power_get_wakeups() - start_wakeups - kept_awake_wakeups;
+   const bool wrap_ok = kept_awake_wakeups == 0 && late_wakeups > 0;
+   printf("ticks past 2^31 (%llu): power-down wakeups %lu during keep-awake, %lu in the next minute %s\n",
+          (unsigned long long)timer_uptime_ticks(), (unsigned long)kept_awake_wakeups,
+          (unsigned long)late_wakeups, wrap_ok ? "OK" : "FAIL");
+   ok = ok && wrap_ok;
+   return ok ? 0 : 1;
+}
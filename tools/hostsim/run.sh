@@ -0,0 +1,48 @@
+#!/bin/sh
+# run.sh: Bygger och kör värdsimuleringarna i tools/hostsim mot källkoden i
+#         repots rot med värddatorns gcc, exempelvis:
+#
+#             sh tools/hostsim/run.sh            (samtliga)
+#             sh tools/hostsim/run.sh tickless   (en simulering)
+#
+#         Källfilerna är kodade i latin-1 och konverteras till UTF-8 i en
+#         temporär katalog innan de kompileras.
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$HERE/../.." && pwd)
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+for f in "$ROOT"/*.c "$ROOT"/*.h; do
+   iconv -f latin1 -t utf-8 "$f" > "$OUT/$(basename "$f")"
+done
+
+CFLAGS="-std=gnu99 -O1 -funsigned-char -fcommon -Wall -Wno-unused-function -include $HERE/include/hostsim_pre.h -I$HERE/include -I$HERE -I$OUT"
+
+sources() {
+   case "$1" in
+      tickless)   echo "timer.c sw_timer.c event.c" ;;
+      power_down) echo "timer.c sw_timer.c event.c power.c" ;;
+      format_check) echo "event.c timer.c sw_timer.c" ;;
+      oversample) echo "adc.c pwm.c misc.c event.c timer.c sw_timer.c" ;;
+      debounce)   echo "debounce.c button.c event.c timer.c sw_timer.c" ;;
+      button_gesture) echo "button_gesture.c debounce.c button.c event.c timer.c sw_timer.c" ;;
+      led_pattern) echo "led_pattern.c led_vect.c led.c misc.c event.c timer.c sw_timer.c" ;;
+   esac
+}
+
+ldflags() {
+   case "$1" in
+      debounce) echo "-Wl,--wrap=button_is_pressed" ;;
+   esac
+}
+
+status=0
+for test in ${*:-tickless power_down format_check oversample debounce button_gesture led_pattern}; do
+   src=""
+   for f in $(sources "$test"); do src="$src $OUT/$f"; done
+   gcc $CFLAGS -o "$OUT/$test" "$HERE/$test.c" "$HERE/hw.c" $src -lm $(ldflags "$test")
+   echo "== $test"
+   "$OUT/$test" || status=1
+done
+exit $status
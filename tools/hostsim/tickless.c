@@ -0,0 +1,208 @@
+/********************************************************************************
+* tickless.c: Värdsimulering av tickless idle (se timer_idle och
+*             sw_timer_idle). Main-loopen körs som i main.c, men utan
+*             TEMP_POWER_DOWN, medan hw.c räknar fram Timer 1.
+*
+*             Varje scenario körs i 10 simulerade minuter med en
+*             mättimer på 60 s, som i temp_init, och i de flesta scenarion
+*             även en timer med udda period (137 ms). CPU:n väcks dessutom
+*             i förtid av "andra avbrott", med fast eller slumpmässigt
+*             intervall, för att pröva omräkningen av redan passerade
+*             tickar i timer_idle_resync.
+*
+*             Kontrolleras:
+*             - varje callback anropas på rätt ms (största avvikelse),
+*             - timer_get_ticks har räknats upp exakt en gång per ms,
+*             - timer_get_us stämmer med simulerad tid och minskar aldrig.
+*               Tiden läses varje räknesteg i viloläget och i callbackarna,
+*               även under perioder där OCR1A har sträckts ut och en del av
+*               perioden redan har räknats in av timer_idle_resync.
+*               hw.c anropar TIMER1_COMPA_vect på samma räknesteg som
+*               jämförelsen, så läget där OCF1A väntar läses dessutom av
+*               vid varje jämförelse genom att TCNT1 och TIFR1 sätts som
+*               de ser ut 0 - 3 räknesteg efter nollställningen, då
+*               avbrottsrutinen hålls tillbaka av ett annat avbrott.
+*             Rapporteras:
+*             - antal uppvaknanden per minut.
+*
+*             Programmet returnerar 1 om någon kontroll misslyckas.
+********************************************************************************/
+#include "hw.h"
+#include "sw_timer.h"
+#include <stdio.h>
+
+#define TICKLESS_MINUTES 10
+#define TICKLESS_PENDING_COUNTS 4 /* Antal räknesteg som avbrottsrutinen hålls tillbaka. */
+
+static struct sw_timer sample_timer;
+static struct sw_timer odd_timer;
+static uint64_t start_ms;
+static uint32_t sample_count, odd_count;
+static int64_t max_error_ms;
+static uint32_t early_period;
+static uint32_t rng = 12345;
+static bool (*early_wake)(void);
+static bool resynced;
+static uint32_t last_us;
+static uint32_t us_errors, us_backwards, us_resynced_reads, us_pending_reads;
+
+/********************************************************************************
+* check: Jämför simulerad tid med förväntad tid för en callback.
+********************************************************************************/
+static void check(const uint64_t expected_ms)
+{
+   int64_t error = (int64_t)(hw_ms() - start_ms) - (int64_t)expected_ms;
+   if (error < 0) error = -error;
+   if (error > max_error_ms) max_error_ms = error;
+   return;
+}
+
+/********************************************************************************
+* check_us: Jämför timer_get_us med simulerad tid och föregående avläsning.
+********************************************************************************/
+static void check_us(void)
+{
+   const uint32_t now_us = timer_get_us();
+
+   if (now_us != (uint32_t)(hw_time * 4)) us_errors++;
+   if ((int32_t)(now_us - last_us) < 0) us_backwards++;
+   last_us = now_us;
+   return;
+}
+
+static void on_sample(struct sw_timer* self)
+{
+   (void)self;
+   check_us();
+   check(60000ULL * ++sample_count);
+   return;
+}
+
+static void on_odd(struct sw_timer* self)
+{
+   (void)self;
+   check_us();
+   check(1000ULL + 137ULL * ++odd_count);
+   return;
+}
+
+/********************************************************************************
+* check_pending: Anropas när TCNT1 har nått OCR1A, dvs. när nästa räknesteg
+*                nollställer TCNT1. Läser av timer_get_us med TCNT1 och TIFR1
+*                som de ser ut under de första räknestegen efter
+*                nollställningen om avbrottsrutinen hålls tillbaka, och
+*                återställer sedan registren.
+********************************************************************************/
+static void check_pending(void)
+{
+   const uint16_t count = TCNT1;
+
+   TIFR1 |= (1 << OCF1A);
+   for (uint16_t i = 0; i < TICKLESS_PENDING_COUNTS; ++i)
+   {
+      TCNT1 = i;
+      if (timer_get_us() != (uint32_t)((hw_time + 1 + i) * 4)) us_errors++;
+      us_pending_reads++;
+   }
+   TIFR1 &= ~(1 << OCF1A);
+   TCNT1 = count;
+   return;
+}
+
+/********************************************************************************
+* on_count: Anropas varje räknesteg i viloläget. Kontrollerar timer_get_us
+*           och anropar därefter scenariots early_wake, om sådan finns.
+*           En period räknas som delvis inräknad från ett uppvaknande i
+*           förtid med utsträckt OCR1A till nästa avbrott för systemticken.
+********************************************************************************/
+static bool on_count(void)
+{
+   if (TCNT1 == 1) resynced = false;
+   if (resynced && OCR1A > TIMER_COMPARE_VALUE) us_resynced_reads++;
+
+   check_us();
+   if (TCNT1 == OCR1A) check_pending();
+
+   if (!early_wake || !early_wake()) return false;
+   if (OCR1A > TIMER_COMPARE_VALUE) resynced = true;
+   return true;
+}
+
+/********************************************************************************
+* early_fixed / early_random: Väcker CPU:n i förtid var early_period:e
+*                             räknesteg, eller slumpmässigt med samma
+*                             medelintervall.
+********************************************************************************/
+static bool early_fixed(void)
+{
+   return hw_time % early_period == 0;
+}
+
+static bool early_random(void)
+{
+   rng = rng * 1103515245UL + 12345UL;
+   return (rng >> 8) % early_period == 0;
+}
+
+/********************************************************************************
+* run: Kör ett scenario och skriver ut resultatet. Returnerar false om en
+*      kontroll misslyckades.
+********************************************************************************/
+static bool run(const char* name, bool (*wake)(void), const uint32_t period, const bool odd)
+{
+   event_dispatch();
+   hw_early_wake = on_count;
+   early_wake = wake;
+   early_period = period;
+   start_ms = hw_ms();
+   sample_count = odd_count = 0;
+   max_error_ms = 0;
+   us_errors = us_backwards = us_resynced_reads = us_pending_reads = 0;
+
+   const uint32_t wakeups = timer_get_wakeups();
+   const uint32_t ticks = timer_get_ticks();
+
+   sw_timer_start(&sample_timer, 60000, 60000);
+   if (odd) sw_timer_start(&odd_timer, 1137, 137);
+
+   while (hw_ms() - start_ms < TICKLESS_MINUTES * 60000ULL)
+   {
+      event_dispatch();
+      sw_timer_idle();
+   }
+   event_dispatch();
+
+   const uint64_t elapsed_ms = hw_ms() - start_ms;
+   const uint32_t counted = timer_get_ticks() - ticks;
+   const bool us_ok = !us_errors && !us_backwards && us_pending_reads && (!wake || us_resynced_reads);
+   const bool ok = max_error_ms == 0 && sample_count == TICKLESS_MINUTES &&
+                   (uint64_t)counted == elapsed_ms && us_ok;
+
+   printf("%-28s samples=%2lu odd=%4lu max error=%lld ms ticks=%lu/%llu wakeups/min=%lu %s\n",
+          name, (unsigned long)sample_count, (unsigned long)odd_count, (long long)max_error_ms,
+          (unsigned long)counted, (unsigned long long)elapsed_ms,
+          (unsigned long)((timer_get_wakeups() - wakeups) / TICKLESS_MINUTES), ok ? "OK" : "FAIL");
+   printf("%-28s timer_get_us: errors=%lu backwards=%lu, reads pending OCF1A=%lu "
+          "partly credited=%lu %s\n", "", (unsigned long)us_errors, (unsigned long)us_backwards,
+          (unsigned long)us_pending_reads, (unsigned long)us_resynced_reads, us_ok ? "OK" : "FAIL");
+
+   sw_timer_stop(&sample_timer);
+   sw_timer_stop(&odd_timer);
+   hw_early_wake = 0;
+   return ok;
+}
+
+int main(void)
+{
+   bool ok = true;
+   OCR1A = TIMER_COMPARE_VALUE;
+   sw_timer_init(&sample_timer, on_sample);
+   sw_timer_init(&odd_timer, on_odd);
+
+   ok &= run("60 s timer only", 0, 0, false);
+   ok &= run("60 s + 137 ms timers", 0, 0, true);
+   ok &= run("early wakes every 3.9 ms", early_fixed, 977, true);
+   ok &= run("early wakes every 49 ms", early_fixed, 12345, true);
+   ok &= run("random early wakes, mean 1 ms", early_random, 250, true);
+   return ok ? 0 : 1;
+}
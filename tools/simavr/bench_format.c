@@ -0,0 +1,119 @@
+/********************************************************************************
+* bench_format.c: Mäter antalet klockcykler för talformateringen i serial.c
+*                 under simavr. Programmet byggs av run.sh mot både
+*                 ursprungskoden, där serial_print_integer m.fl. anropar
+*                 sprintf och serial_print_char väntar på USART, och mot
+*                 nuvarande källkod med serial_print_digits och sändbuffert.
+*
+*                 Timer 1 räknar med prescaler 1, dvs. en gång per klock-
+*                 cykel, medan avbrott är inaktiverade. För varje tal mäts
+*                 först utskriftsfunktionen och sedan serial_print_string med
+*                 samma text. Skillnaden är kostnaden för formateringen, då
+*                 väntan på USART i ursprungskoden blir lika lång i båda
+*                 mätningarna (räknat från första skrivna tecknet). Flyttalen
+*                 är valda så att båda versionerna skriver samma text.
+*
+*                 Resultaten skrivs ut via USART, varefter CPU:n försätts i
+*                 viloläge med avbrott inaktiverade, vilket avslutar simavr.
+********************************************************************************/
+#include "serial.h"
+#include <avr/sleep.h>
+#include <stdio.h>
+
+#ifndef BENCH_TREE
+#define BENCH_TREE "?"
+#endif
+
+#define BENCH_BAUD 57600 /* Ryms i ursprungskodens uint16_t, ca 2800 cykler per tecken. */
+
+static volatile int32_t bench_value;  /* Heltal som skrivs ut (volatile, så att anropen inte optimeras). */
+static volatile double bench_double;  /* Flyttal som skrivs ut. */
+static char bench_text[24];           /* Förväntad text, skrivs via serial_print_string. */
+
+static void bench_integer(void) { serial_print_integer(bench_value); }
+static void bench_unsigned(void) { serial_print_unsigned((uint32_t)bench_value); }
+static void bench_double_print(void) { serial_print_double(bench_double); }
+static void bench_string(void) { serial_print_string(bench_text); }
+
+/********************************************************************************
+* bench_drain: Väntar med avbrott aktiverade tills tidigare utskrifter har
+*              skickats, så att varje mätning startar med tom USART.
+********************************************************************************/
+static void bench_drain(void)
+{
+   sei();
+   _delay_ms(10);
+   cli();
+   return;
+}
+
+/********************************************************************************
+* bench_cycles: Returnerar antalet klockcykler för ett anrop av angiven
+*               funktion, inklusive anrop och avläsning av TCNT1.
+********************************************************************************/
+static uint16_t bench_cycles(void (*function)(void))
+{
+   bench_drain();
+   TCNT1 = 0;
+   function();
+   const uint16_t cycles = TCNT1;
+   return cycles;
+}
+
+/********************************************************************************
+* bench_report: Mäter angiven utskriftsfunktion mot serial_print_string med
+*               texten i bench_text och skriver ut resultatet.
+********************************************************************************/
+static void bench_report(const char* name, void (*function)(void))
+{
+   const uint16_t total = bench_cycles(function);
+   const uint16_t string = bench_cycles(bench_string);
+
+   bench_drain();
+   serial_print_string(BENCH_TREE " ");
+   serial_print_string(name);
+   serial_print_string(" \"");
+   serial_print_string(bench_text);
+   serial_print_string("\": total=");
+   serial_print_unsigned(total);
+   serial_print_string(" string=");
+   serial_print_unsigned(string);
+   serial_print_string(" format=");
+   serial_print_integer((int32_t)total - (int32_t)string);
+   serial_print_string(" cycles\n");
+   return;
+}
+
+int main(void)
+{
+   static const int32_t integers[] = { 0, 7, 1234, -56789, 2147483647L, -2147483647L - 1 };
+   static const double doubles[] = { 21.25, -12.75, 1023.5 };
+
+   serial_init(BENCH_BAUD);
+   TCCR1A = 0x00;
+   TCCR1B = (1 << CS10);
+
+   for (uint8_t i = 0; i < sizeof(integers) / sizeof(integers[0]); ++i)
+   {
+      bench_value = integers[i];
+      sprintf(bench_text, "%ld", integers[i]);
+      bench_report("integer", bench_integer);
+      sprintf(bench_text, "%lu", (uint32_t)integers[i]);
+      bench_report("unsigned", bench_unsigned);
+   }
+
+   for (uint8_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); ++i)
+   {
+      bench_double = doubles[i];
+      const int32_t centi = (int32_t)(doubles[i] * 100);
+      const uint32_t magnitude = centi < 0 ? -centi : centi;
+      sprintf(bench_text, "%s%lu.%02lu", centi < 0 ? "-" : "", magnitude / 100, magnitude % 100);
+      bench_report("double", bench_double_print);
+   }
+
+   bench_drain();
+   set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+   sleep_enable();
+   sleep_cpu();
+   return 0;
+}
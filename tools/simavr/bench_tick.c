@@ -0,0 +1,113 @@
+/********************************************************************************
+* bench_tick.c: Mäter hur stor andel av CPU-tiden som tidräkningens avbrott
+*               tar under simavr. Programmet byggs av run.sh mot både
+*               ursprungskoden, med två timrar i overflow mode som ger
+*               avbrott var 0.128 ms vardera (Timer 0 och Timer 2), och mot
+*               nuvarande källkod med en gemensam systemtick på 1 ms via
+*               Timer 1 i CTC mode.
+*
+*               Efter setup räknas antalet varv i en tom loop under en fast
+*               referensperiod, först med avbrott inaktiverade och sedan med
+*               avbrott aktiverade. Andelen CPU-tid för avbrotten blir
+*               1 - varv med avbrott / varv utan avbrott. I nuvarande källkod
+*               anropas även event_dispatch i loopen, eftersom systemtickens
+*               arbete delvis sker i main-loopen. Knapptryckningar och
+*               temperaturmätningar (var 60:e sekund) sker inte under
+*               mätningen, så resultatet gäller i princip enbart tidräkningen.
+*
+*               Referensperioden mäts med en timer som källkoden inte
+*               använder: Timer 1 i ursprungskoden och Timer 2 i nuvarande
+*               källkod (som stängs av i PRR av power_init). Båda räknar med
+*               prescaler 1024, dvs. 64 us per steg, och perioden är 61
+*               overflows för Timer 2 (999.4 ms).
+*
+*               Resultaten skrivs ut via USART, varefter CPU:n försätts i
+*               viloläge med avbrott inaktiverade, vilket avslutar simavr.
+********************************************************************************/
+#include "main_header.h"
+#include <avr/sleep.h>
+
+#ifndef BENCH_TREE
+#define BENCH_TREE "?"
+#endif
+
+#define BENCH_PERIOD_OVERFLOWS 61 /* Referensperiod räknat i overflows för en 8-bitars timer. */
+
+#ifdef BENCH_TREE_baseline
+#define BENCH_LOOP_HOOK()
+#else
+#define BENCH_LOOP_HOOK() event_dispatch()
+#endif
+
+/********************************************************************************
+* bench_iterations: Räknar antalet varv i loopen under referensperioden.
+*
+*                   - interrupts: true om avbrott ska vara aktiverade.
+********************************************************************************/
+static uint32_t bench_iterations(const bool interrupts)
+{
+   uint32_t iterations = 0;
+
+#ifdef BENCH_TREE_baseline
+   TCCR1A = 0x00;
+   TCCR1B = (1 << CS12) | (1 << CS10);
+   TCNT1 = 0;
+   if (interrupts) sei();
+
+   while (TCNT1 < BENCH_PERIOD_OVERFLOWS * 256U)
+   {
+      iterations++;
+      BENCH_LOOP_HOOK();
+   }
+#else
+   uint8_t overflows = 0;
+   PRR &= ~(1 << PRTIM2);
+   TCCR2A = 0x00;
+   TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20);
+   TCNT2 = 0;
+   TIFR2 = (1 << TOV2);
+   if (interrupts) sei();
+
+   while (overflows < BENCH_PERIOD_OVERFLOWS)
+   {
+      if (TIFR2 & (1 << TOV2))
+      {
+         TIFR2 = (1 << TOV2);
+         overflows++;
+      }
+      iterations++;
+      BENCH_LOOP_HOOK();
+   }
+#endif
+
+   cli();
+   return iterations;
+}
+
+int main(void)
+{
+   setup();
+   cli();
+
+   const uint32_t idle = bench_iterations(false);
+   const uint32_t loaded = bench_iterations(true);
+   const uint32_t share = loaded < idle ? (uint32_t)(1000 - (uint64_t)loaded * 1000 / idle) : 0;
+
+   sei();
+   serial_print_string(BENCH_TREE " loop iterations per 999.4 ms: interrupts off=");
+   serial_print_unsigned(idle);
+   serial_print_string(" on=");
+   serial_print_unsigned(loaded);
+   serial_print_string(" interrupt share=");
+   serial_print_unsigned(share / 10);
+   serial_print_string(".");
+   serial_print_unsigned(share % 10);
+   serial_print_string(" %\n");
+   _delay_ms(100);
+
+   cli();
+   set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+   sleep_enable();
+   sleep_cpu();
+   return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+# run.sh: Bygger benchmarkprogrammen i tools/simavr med avr-gcc och kör dem
+#         under simavr, både mot ursprungskoden (repots första incheckning)
+#         och mot nuvarande källkod i repots rot, exempelvis:
+#
+#             sh tools/simavr/run.sh          (samtliga)
+#             sh tools/simavr/run.sh tick     (ett program)
+#
+#         Resultaten skrivs ut via USART, som simavr skriver till stdout.
+#         Kräver avr-gcc, avr-libc och simavr i PATH (eller SIMAVR=...).
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$HERE/../.." && pwd)
+SIMAVR=${SIMAVR:-simavr}
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+mkdir "$OUT/baseline" "$OUT/current"
+git -C "$ROOT" archive "$(git -C "$ROOT" rev-list --max-parents=0 HEAD)" | tar -x -C "$OUT/baseline"
+cp "$ROOT"/*.c "$ROOT"/*.h "$OUT/current"
+
+CFLAGS="-mmcu=atmega328p -Os -std=gnu99 -funsigned-char -Wall -Wno-unused-function"
+
+sources() {
+   case "$1-$2" in
+      format-baseline) echo "serial.c" ;;
+      format-current)  echo "serial.c event.c" ;;
+      tick-*)          (cd "$OUT/$2" && ls *.c | grep -v '^main\.c$') ;;
+   esac
+}
+
+for bench in ${*:-format tick}; do
+   for tree in baseline current; do
+      src=""
+      for f in $(sources "$bench" "$tree"); do src="$src $OUT/$tree/$f"; done
+      avr-gcc $CFLAGS -DBENCH_TREE="\"$tree\"" -DBENCH_TREE_$tree -I"$OUT/$tree" \
+         -o "$OUT/$bench-$tree.elf" "$HERE/bench_$bench.c" $src
+      echo "== $bench ($tree)"
+      "$SIMAVR" -m atmega328p -f 16000000 "$OUT/$bench-$tree.elf"
+   done
+done
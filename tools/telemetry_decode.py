@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+telemetry_decode.py: Avkodar binära telemetriramar (se telemetry.h) från
+                     temperatursensorn och skriver ut dem som text.
+
+Ramarna är COBS-kodade och avslutas med en nolla. Varje avkodad ram är
+13 byte: löpnummer, tidsstämpel, AD-värde, temperatur, mätperiod samt
+CRC-16 (CCITT, polynom 0x1021, startvärde 0xFFFF).
+
+Tidsstämpeln är de låga 32 bitarna av drifttiden vid mätningen och slår
+runt efter ca 49 dygn, vilket räknas in här så att utskriven tid är
+monoton. Ett mindre hopp bakåt tolkas i stället som en omstart.
+
+Användning:
+    python3 telemetry_decode.py /dev/ttyACM0 [--baud 9600]
+    python3 telemetry_decode.py - < inspelning.bin
+"""
+import argparse
+import struct
+import sys
+
+PAYLOAD_FORMAT = "<BIHhH"
+PAYLOAD_SIZE = struct.calcsize(PAYLOAD_FORMAT)
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    """Beräknar CRC-16 på samma sätt som _crc_xmodem_update i avr-libc."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Avkodar en COBS-kodad ram (utan avslutande nolla)."""
+    output = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("ogiltig COBS-kod")
+        output += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            output.append(0)
+    return bytes(output)
+
+
+def decode_frame(encoded):
+    """Avkodar en ram och returnerar fälten, eller kastar ValueError."""
+    frame = cobs_decode(encoded)
+    if len(frame) != PAYLOAD_SIZE + 2:
+        raise ValueError("fel ramlängd: %d" % len(frame))
+    payload, crc = frame[:PAYLOAD_SIZE], frame[PAYLOAD_SIZE:]
+    if crc16_ccitt(payload) != struct.unpack("<H", crc)[0]:
+        raise ValueError("felaktig CRC")
+    return struct.unpack(PAYLOAD_FORMAT, payload)
+
+
+def read_chunks(args):
+    if args.port == "-":
+        stream = sys.stdin.buffer
+        while True:
+            chunk = stream.read(1)
+            if not chunk:
+                return
+            yield chunk
+    else:
+        import serial  # pyserial
+        with serial.Serial(args.port, args.baud) as port:
+            while True:
+                yield port.read(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1].strip())
+    parser.add_argument("port", help="serieport, eller - för standard in")
+    parser.add_argument("--baud", type=int, default=9600)
+    args = parser.parse_args()
+
+    buffer = bytearray()
+    last_sequence = None
+    last_timestamp = None
+    wraps = 0
+    for chunk in read_chunks(args):
+        for byte in chunk:
+            if byte != 0:
+                buffer.append(byte)
+                continue
+            if not buffer:
+                continue
+            try:
+                seq, timestamp, raw, centi, period = decode_frame(bytes(buffer))
+            except ValueError as error:
+                print("trasig ram (%s): %s" % (error, buffer.hex()), file=sys.stderr)
+            else:
+                if last_sequence is not None and seq != (last_sequence + 1) & 0xFF:
+                    print("tappade %d ram(ar)" % ((seq - last_sequence - 1) & 0xFF),
+                          file=sys.stderr)
+                last_sequence = seq
+                if last_timestamp is not None and timestamp < last_timestamp:
+                    if last_timestamp - timestamp > 0x80000000:
+                        wraps += 1
+                    else:
+                        print("tidsstämpeln gick bakåt, omstart?", file=sys.stderr)
+                        wraps = 0
+                last_timestamp = timestamp
+                timestamp += wraps << 32
+                print("#%3d  t=%10d ms  adc=%4d  temperature=%7.2f C  period=%5d ms"
+                      % (seq, timestamp, raw, centi / 100.0, period))
+                sys.stdout.flush()
+            buffer.clear()
+
+
+if __name__ == "__main__":
+    main()